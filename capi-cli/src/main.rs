@@ -3,6 +3,42 @@ use anyhow::Result;
 use std::sync::Arc;
 use dialoguer::{Select, Confirm, theme::ColorfulTheme};
 
+/// Counts heap allocations made from Rust so `capi benchmark` can report
+/// allocations per streamed token. C++ allocations are not visible here.
+/// Built only with `--features alloc-stats`, since it taxes every allocation.
+#[cfg(feature = "alloc-stats")]
+mod alloc_stats {
+    use std::alloc::{GlobalAlloc, Layout, System};
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    struct CountingAllocator;
+
+    static ALLOCATIONS: AtomicUsize = AtomicUsize::new(0);
+
+    unsafe impl GlobalAlloc for CountingAllocator {
+        unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+            ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+            System.alloc(layout)
+        }
+
+        unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+            System.dealloc(ptr, layout)
+        }
+
+        unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+            ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+            System.realloc(ptr, layout, new_size)
+        }
+    }
+
+    #[global_allocator]
+    static GLOBAL: CountingAllocator = CountingAllocator;
+
+    pub fn allocations() -> usize {
+        ALLOCATIONS.load(Ordering::Relaxed)
+    }
+}
+
 #[derive(Parser)]
 #[command(name = "capi")]
 #[command(about = "Local LLM inference with OpenVINO", long_about = None)]
@@ -22,11 +58,17 @@ enum Commands {
     },
     /// Start interactive chat with a model
     Run {
-        /// Model ID or name
+        /// Model ID or name, or a LoRA adapter ID to run it on its base model
         model: String,
         /// Device to run inference on (e.g., CPU, GPU)
         #[arg(long, short)]
         device: Option<String>,
+        /// LoRA adapter to apply
+        #[arg(long)]
+        adapter: Option<String>,
+        /// Adapter blend factor; defaults to the one it was registered with
+        #[arg(long)]
+        alpha: Option<f32>,
     },
     /// Generate single response (non-interactive)
     Generate {
@@ -96,11 +138,55 @@ enum ModelCommands {
         #[arg(long)]
         name: Option<String>,
     },
-    /// Remove a model
+    /// Enable or disable prompt-lookup decoding for a model
+    PromptLookup {
+        /// Model ID
+        model_id: String,
+        /// on or off
+        state: String,
+    },
+    /// Set whether a model is an LLM or an embedding model
+    SetType {
+        /// Model ID
+        model_id: String,
+        /// llm or embedding
+        model_type: String,
+    },
+    /// Set a model's KV cache precision
+    KvPrecision {
+        /// Model ID
+        model_id: String,
+        /// auto, f16, u8, u4, or default to use the config setting
+        precision: String,
+    },
+    /// Remove a model and its adapters
     Remove {
         /// Model ID to remove
         model_id: String,
     },
+    /// Register a LoRA adapter (.safetensors) for a base model
+    AddAdapter {
+        /// Base model ID
+        model_id: String,
+        /// Path to the adapter weights
+        path: String,
+        /// Adapter ID; defaults to the file name
+        #[arg(long)]
+        id: Option<String>,
+        /// Default blend factor
+        #[arg(long, default_value = "1.0")]
+        alpha: f64,
+    },
+    /// List the LoRA adapters of a base model
+    Adapters {
+        /// Base model ID
+        model_id: String,
+    },
+    /// Remove a LoRA adapter
+    RemoveAdapter {
+        /// Adapter ID
+        adapter_id: String,
+    },
     /// Search HuggingFace models
     Search {
         /// Search query
@@ -132,6 +218,7 @@ async fn main() -> Result<()> {
                     let resources = capi_core::detect_system_resources().ok();
                     let devices = capi_core::detect_devices()?;
                     let selected_device = capi_core::select_best_device(&devices, &config.device_preference);
+                    let compile_cache = capi_core::model_manager::CompileCache::new(&config);
 
                     println!("Installed models ({}):\n", models.len());
                     for (idx, model) in models.iter().enumerate() {
@@ -177,20 +264,49 @@ async fn main() -> Result<()> {
                             .map(|ts| format_timestamp(ts))
                             .unwrap_or_else(|| "never".to_string());
 
-                        println!("  [{:2}] {:<35} {:>6} {:>6} {:>7} {} {}",
+                        let cache_str = match &selected_device {
+                            Some(dev) => {
+                                let path = std::path::Path::new(&model.path);
+                                let load_path = if path.is_dir() || path.extension().map_or(false, |e| e == "gguf") {
+                                    path
+                                } else {
+                                    path.parent().unwrap_or(path)
+                                };
+                                if compile_cache.is_warm(load_path, dev) { "warm" } else { "cold" }
+                            }
+                            None => "-",
+                        };
+
+                        let type_str = if model.is_embedding() { "  [embedding]" } else { "" };
+
+                        println!("  [{:2}] {:<35} {:>6} {:>6} {:>7} {} {:>4} {}{}",
                             idx + 1,
                             model.name,
                             quant,
                             size_str,
                             mem_str,
                             fit_indicator,
-                            last_used
+                            cache_str,
+                            last_used,
+                            type_str
                         );
+                        for adapter in registry.list_adapters(&model.id)? {
+                            println!("         └ {} (LoRA, alpha {})", adapter.id, adapter.alpha);
+                        }
                     }
-                    println!("\nLegend: ✓ fits  ⚠ tight  ✗ insufficient memory");
+                    println!("\nLegend: ✓ fits  ⚠ tight  ✗ insufficient memory  |  warm = compiled model cached");
                 }
             }
             ModelCommands::Info { model } => {
+                let config = capi_core::Config::load()?;
+                let db = Arc::new(capi_core::Database::open(config.database_path())?);
+                let registry = capi_core::Registry::new(db);
+
+                if let Some(record) = registry.get_model(&model)? {
+                    print_local_model_info(&config, &registry, &record)?;
+                    return Ok(());
+                }
+
                 println!("Fetching model info for: {}", model);
                 let downloader = capi_core::Downloader::new();
 
@@ -263,6 +379,9 @@ async fn main() -> Result<()> {
                     last_used: None,
                     estimated_memory_bytes: estimated_memory,
                     context_override: None,
+                    prompt_lookup: false,
+                    model_type: capi_core::model_manager::detect_model_type(&model_file).to_string(),
+                    kv_cache_precision: None,
                 };
 
                 registry.add_model(model_record)?;
@@ -302,6 +421,9 @@ async fn main() -> Result<()> {
                     last_used: None,
                     estimated_memory_bytes: estimated_memory,
                     context_override: None,
+                    prompt_lookup: false,
+                    model_type: capi_core::model_manager::detect_model_type(&model_file).to_string(),
+                    kv_cache_precision: None,
                 };
 
                 registry.add_model(model_record)?;
@@ -309,6 +431,49 @@ async fn main() -> Result<()> {
                 println!("\nYou can now use this model with:");
                 println!("  capi run {}", model);
             }
+            ModelCommands::PromptLookup { model_id, state } => {
+                let enabled = match state.to_lowercase().as_str() {
+                    "on" => true,
+                    "off" => false,
+                    _ => {
+                        eprintln!("Invalid state: {}. Use 'on' or 'off'", state);
+                        return Ok(());
+                    }
+                };
+
+                let config = capi_core::Config::load()?;
+                let db = Arc::new(capi_core::Database::open(config.database_path())?);
+                let registry = capi_core::Registry::new(db);
+
+                registry.set_prompt_lookup(&model_id, enabled)?;
+                println!("Prompt-lookup decoding {} for {}", if enabled { "enabled" } else { "disabled" }, model_id);
+                println!("Restart the server for loaded models to pick this up.");
+            }
+            ModelCommands::SetType { model_id, model_type } => {
+                let config = capi_core::Config::load()?;
+                let db = Arc::new(capi_core::Database::open(config.database_path())?);
+                let registry = capi_core::Registry::new(db);
+
+                let model_type = model_type.to_lowercase();
+                registry.set_model_type(&model_id, &model_type)?;
+                let described = if model_type == capi_core::db::models::MODEL_TYPE_LLM { "an LLM" } else { "an embedding model" };
+                println!("{} is now registered as {}", model_id, described);
+            }
+            ModelCommands::KvPrecision { model_id, precision } => {
+                let config = capi_core::Config::load()?;
+                let db = Arc::new(capi_core::Database::open(config.database_path())?);
+                let registry = capi_core::Registry::new(db);
+
+                let precision = precision.to_lowercase();
+                let value = (precision != "default").then_some(precision.as_str());
+                registry.set_kv_cache_precision(&model_id, value)?;
+
+                match value {
+                    Some(precision) => println!("KV cache precision for {} set to {}", model_id, precision),
+                    None => println!("KV cache precision for {} reset to the config default ({})", model_id, config.kv_cache.precision),
+                }
+                println!("Restart the server for loaded models to pick this up.");
+            }
             ModelCommands::Remove { model_id } => {
                 let config = capi_core::Config::load()?;
                 let db = Arc::new(capi_core::Database::open(config.database_path())?);
@@ -317,6 +482,63 @@ async fn main() -> Result<()> {
                 registry.remove_model(&model_id)?;
                 println!("Removed model: {}", model_id);
             }
+            ModelCommands::AddAdapter { model_id, path, id, alpha } => {
+                let config = capi_core::Config::load()?;
+                let db = Arc::new(capi_core::Database::open(config.database_path())?);
+                let registry = capi_core::Registry::new(db);
+
+                let adapter_path = std::path::Path::new(&path);
+                if !adapter_path.is_file() {
+                    return Err(anyhow::anyhow!("Adapter file not found: {}", path));
+                }
+                let adapter_path = adapter_path.canonicalize()?;
+                let adapter_id = id.unwrap_or_else(|| {
+                    adapter_path.file_stem()
+                        .map(|stem| stem.to_string_lossy().to_string())
+                        .unwrap_or_else(|| path.clone())
+                });
+
+                let timestamp = std::time::SystemTime::now()
+                    .duration_since(std::time::UNIX_EPOCH)?
+                    .as_secs() as i64;
+
+                registry.add_adapter(capi_core::db::AdapterRecord {
+                    id: adapter_id.clone(),
+                    base_model_id: model_id.clone(),
+                    name: adapter_id.clone(),
+                    path: adapter_path.to_string_lossy().to_string(),
+                    alpha,
+                    created_at: timestamp,
+                })?;
+                println!("✓ Adapter {} registered for {}", adapter_id, model_id);
+                println!("\nUse it with:");
+                println!("  capi run {}", adapter_id);
+                println!("  or \"adapter\": \"{}\" in /v1/chat/completions requests for {}", adapter_id, model_id);
+                println!("Restart the server for loaded models to pick this up.");
+            }
+            ModelCommands::Adapters { model_id } => {
+                let config = capi_core::Config::load()?;
+                let db = Arc::new(capi_core::Database::open(config.database_path())?);
+                let registry = capi_core::Registry::new(db);
+
+                let adapters = registry.list_adapters(&model_id)?;
+                if adapters.is_empty() {
+                    println!("No adapters registered for {}", model_id);
+                } else {
+                    println!("Adapters of {} ({}):\n", model_id, adapters.len());
+                    for adapter in adapters {
+                        println!("  {:<30} alpha {:<5} {}", adapter.id, adapter.alpha, adapter.path);
+                    }
+                }
+            }
+            ModelCommands::RemoveAdapter { adapter_id } => {
+                let config = capi_core::Config::load()?;
+                let db = Arc::new(capi_core::Database::open(config.database_path())?);
+                let registry = capi_core::Registry::new(db);
+
+                registry.remove_adapter(&adapter_id)?;
+                println!("Removed adapter: {}", adapter_id);
+            }
             ModelCommands::Search { query } => {
                 let downloader = capi_core::Downloader::new();
                 let results = downloader.search_models(&query).await?;
@@ -348,7 +570,7 @@ async fn main() -> Result<()> {
                 }
             }
         },
-        Commands::Run { model, device } => {
+        Commands::Run { model, device, adapter, alpha } => {
             use std::io::{self, Write};
             use crossterm::{
                 event::{self, Event, KeyCode, KeyEventKind},
@@ -359,6 +581,17 @@ async fn main() -> Result<()> {
             let db = Arc::new(capi_core::Database::open(config.database_path())?);
             let registry = capi_core::Registry::new(db);
 
+            // An adapter ID runs its base model with the adapter applied
+            let adapter_record = match &adapter {
+                Some(id) => Some(registry.get_adapter(id)?
+                    .ok_or_else(|| anyhow::anyhow!("Adapter not found: {}", id))?),
+                None => registry.get_adapter(&model)?,
+            };
+            let model = adapter_record.as_ref()
+                .filter(|_| adapter.is_none())
+                .map(|record| record.base_model_id.clone())
+                .unwrap_or(model);
+
             let model_record = registry.get_model(&model)?
                 .or_else(|| {
                     registry.list_models()
@@ -370,6 +603,16 @@ async fn main() -> Result<()> {
                 })
                 .ok_or_else(|| anyhow::anyhow!("Model not found: {}", model))?;
 
+            if let Some(record) = adapter_record.as_ref().filter(|record| record.base_model_id != model_record.id) {
+                return Err(anyhow::anyhow!("Adapter {} belongs to {}, not {}", record.id, record.base_model_id, model_record.id));
+            }
+            let lora_adapters: Vec<_> = adapter_record.iter()
+                .map(|record| capi_core::inference::genai::LoraAdapter {
+                    name: record.id.clone(),
+                    path: record.path.clone(),
+                })
+                .collect();
+
             println!("Loading {}...", model_record.name);
             println!("Model path: {}", model_record.path);
 
@@ -387,9 +630,26 @@ async fn main() -> Result<()> {
 
             println!("Loading on device: {}...", selected_device);
 
-            let mut session = capi_core::InferenceSession::load(model_path, &selected_device)?;
+            let kv_cache = registry.kv_cache_settings_for(&config, &model_record);
+            let mut session = capi_core::InferenceSession::load_speculative(
+                model_path,
+                &selected_device,
+                &capi_core::inference::genai::SpeculativeConfig::default(),
+                &kv_cache,
+                &lora_adapters,
+            )?;
+            if let Some(record) = &adapter_record {
+                let alpha = alpha.unwrap_or(record.alpha as f32);
+                session.set_adapter(Some((record.id.as_str(), alpha)))?;
+                println!("Applying adapter {} (alpha {})", record.id, alpha);
+            }
             session.start_chat()?;
 
+            let load_stats = session.load_stats();
+            println!("Loaded in {:.0} ms ({})",
+                load_stats.load_time_ms,
+                if load_stats.cache_hit { "compile cache hit" } else { "cold compile" });
+
             println!("Ready! Type your message (or /exit to quit, ESC to stop generation)\n");
 
             enable_raw_mode()?;
@@ -490,9 +750,11 @@ async fn main() -> Result<()> {
                     };
 
                     // In raw mode, replace \n with \r\n for proper line breaks
-                    let display_token = display_token.replace("\n", "\r\n");
-
-                    print!("{}", display_token);
+                    if display_token.contains('\n') {
+                        print!("{}", display_token.replace("\n", "\r\n"));
+                    } else {
+                        print!("{}", display_token);
+                    }
                     use std::io::Write;
                     std::io::stdout().flush().ok();
                     true
@@ -536,7 +798,14 @@ async fn main() -> Result<()> {
             let device = capi_core::select_best_device(&devices, &config.device_preference)
                 .unwrap_or_else(|| "CPU".to_string());
 
-            let mut session = capi_core::InferenceSession::load(model_path, &device)?;
+            let kv_cache = registry.kv_cache_settings_for(&config, active_model);
+            let mut session = capi_core::InferenceSession::load_speculative(
+                model_path,
+                &device,
+                &capi_core::inference::genai::SpeculativeConfig::default(),
+                &kv_cache,
+                &[],
+            )?;
             let output = session.generate(&prompt, 50)?;
 
             println!("{}", output);
@@ -564,8 +833,26 @@ async fn main() -> Result<()> {
             let device = capi_core::select_best_device(&devices, &config.device_preference)
                 .unwrap_or_else(|| "CPU".to_string());
 
-            println!("Loading model on {}...", device);
-            let mut session = capi_core::InferenceSession::load(model_path, &device)?;
+            if model_record.is_embedding() {
+                return benchmark_embeddings(&config, model_path, &device, runs).await;
+            }
+
+            let speculative = registry.speculative_config_for(&config, &model_record, &device)?;
+            if !speculative.draft_model_path.is_empty() {
+                println!("Loading model on {} with draft model {}...", device, speculative.draft_model_path);
+            } else if speculative.prompt_lookup {
+                println!("Loading model on {} with prompt-lookup decoding...", device);
+            } else {
+                println!("Loading model on {}...", device);
+            }
+            let speculative_enabled = !speculative.draft_model_path.is_empty() || speculative.prompt_lookup;
+            let kv_cache = registry.kv_cache_settings_for(&config, &model_record);
+            let mut session = capi_core::InferenceSession::load_speculative(model_path, &device, &speculative, &kv_cache, &[])?;
+
+            let load_stats = session.load_stats().clone();
+            println!("Load time: {:.0} ms ({})",
+                load_stats.load_time_ms,
+                if load_stats.cache_hit { "compile cache hit" } else { "cold compile" });
 
             let test_prompts = vec![
                 "Hello, how are you?",
@@ -585,14 +872,39 @@ async fn main() -> Result<()> {
                     println!("  Prompt: {}", prompt);
                     println!("    Tokens/sec: {:.2}", metrics.tokens_per_second);
                     println!("    TTFT: {:.2} ms", metrics.time_to_first_token_ms);
+                    println!("    TPOT: {:.2} ms (ITL p50 {:.2} / p90 {:.2} / p99 {:.2} ms)",
+                        metrics.time_per_output_token_ms, metrics.itl_p50_ms, metrics.itl_p90_ms, metrics.itl_p99_ms);
+                    println!("    Tokenize {:.2} ms, inference {:.2} ms, detokenize {:.2} ms",
+                        metrics.tokenization_ms, metrics.inference_ms, metrics.detokenization_ms);
                     println!("    Input tokens: {}", metrics.num_input_tokens);
                     println!("    Output tokens: {}", metrics.num_output_tokens);
+                    if speculative_enabled {
+                        println!("    Draft acceptance: {:.1}% ({:.2}x tokens per step)",
+                            metrics.acceptance_rate * 100.0, metrics.speculative_speedup);
+                    }
 
                     all_tps.push(metrics.tokens_per_second);
                     all_ttft.push(metrics.time_to_first_token_ms);
                 }
             }
 
+            // Streaming path: count Rust-side allocations per delivered token
+            #[cfg(feature = "alloc-stats")]
+            {
+                println!("\nStreaming allocations:");
+                let mut streamed_tokens = 0usize;
+                let allocations_before = alloc_stats::allocations();
+                session.generate_stream(test_prompts[2], 50, |_token| {
+                    streamed_tokens += 1;
+                    true
+                })?;
+                let allocations = alloc_stats::allocations() - allocations_before;
+                if streamed_tokens > 0 {
+                    println!("  {} allocations over {} tokens ({:.2} per token)",
+                        allocations, streamed_tokens, allocations as f64 / streamed_tokens as f64);
+                }
+            }
+
             let avg_tps: f32 = all_tps.iter().sum::<f32>() / all_tps.len() as f32;
             let avg_ttft: f32 = all_ttft.iter().sum::<f32>() / all_ttft.len() as f32;
 
@@ -780,6 +1092,9 @@ async fn main() -> Result<()> {
                 last_used: None,
                 estimated_memory_bytes: estimated_memory,
                 context_override: None,
+                prompt_lookup: false,
+                model_type: capi_core::db::models::MODEL_TYPE_LLM.to_string(),
+                kv_cache_precision: None,
             };
 
             registry.add_model(model_record)?;
@@ -799,6 +1114,27 @@ async fn main() -> Result<()> {
                     println!("  Device preference: {:?}", config.device_preference);
                     println!("  Resource mode: {:?}", config.resource_mode);
                     println!("  Default context length: {}K", config.default_context_length / 1024);
+                    println!("  Prefix caching: {}", config.scheduler.enable_prefix_caching);
+                    println!("  Replicas per model: {}", config.scheduler.replicas);
+                    for (model, replicas) in &config.scheduler.model_replicas {
+                        println!("  Replicas: {} -> {}", model, replicas);
+                    }
+                    println!("  Request queue: {} in flight, {} waiting per model",
+                        config.queue.max_in_flight, config.queue.max_queue_depth);
+                    match config.residency.memory_budget_gb {
+                        Some(gb) => println!("  Model memory budget: {} GiB", gb),
+                        None => println!("  Model memory budget: unlimited"),
+                    }
+                    println!("  Keep alive: {}s", config.residency.keep_alive_secs);
+                    if !config.residency.pinned.is_empty() {
+                        println!("  Pinned models: {}", config.residency.pinned.join(", "));
+                    }
+                    println!("  Compile cache: {} (max {} GB)", config.compile_cache_dir().display(), config.compile_cache_max_gb);
+                    for (target, draft) in &config.speculative.draft_models {
+                        println!("  Speculative: {} -> {} ({} tokens/step)", target, draft, config.speculative.num_assistant_tokens);
+                    }
+                    println!("  Prompt lookup: {} tokens/step, n-grams up to {}",
+                        config.speculative.num_assistant_tokens, config.speculative.max_ngram_size);
                     println!("  Auto start: {}", config.auto_start);
                     println!("  Keep server running: {}", config.keep_server_running);
                 }
@@ -866,6 +1202,50 @@ async fn main() -> Result<()> {
     Ok(())
 }
 
+/// Embedding throughput per batch size, through the same micro-batching
+/// engine the server uses. Each request is exactly one batch.
+async fn benchmark_embeddings(config: &capi_core::Config, model_path: &std::path::Path, device: &str, runs: usize) -> Result<()> {
+    const BATCH_SIZES: [usize; 6] = [1, 4, 8, 16, 32, 64];
+
+    let mut settings = config.embeddings.clone();
+    settings.max_batch_size = BATCH_SIZES[BATCH_SIZES.len() - 1];
+    // Requests are sent one at a time; waiting for company would only add latency
+    settings.batch_window_ms = 0;
+
+    println!("Loading embedding model on {}...", device);
+    let session = capi_core::EmbeddingSession::load(model_path, device, &settings)?;
+
+    let load_stats = session.load_stats();
+    println!("Load time: {:.0} ms ({})",
+        load_stats.load_time_ms,
+        if load_stats.cache_hit { "compile cache hit" } else { "cold compile" });
+    println!("Embedding size: {}\n", session.dim());
+
+    // RAG-sized chunks of varying length
+    let chunk = "OpenVINO accelerates deep learning inference across Intel CPUs, GPUs and NPUs. ";
+    let texts: Vec<String> = (0..BATCH_SIZES[BATCH_SIZES.len() - 1])
+        .map(|i| chunk.repeat(1 + i % 4))
+        .collect();
+
+    println!("  Batch   Embeddings/sec   ms/batch");
+    for batch_size in BATCH_SIZES {
+        let batch = texts[..batch_size].to_vec();
+        session.embed(batch.clone()).await?;
+
+        let started = std::time::Instant::now();
+        for _ in 0..runs {
+            session.embed(batch.clone()).await?;
+        }
+        let elapsed = started.elapsed().as_secs_f64();
+        let per_sec = (batch_size * runs) as f64 / elapsed;
+
+        println!("  {:>5}   {:>14.1}   {:>8.2}", batch_size, per_sec, elapsed * 1000.0 / runs as f64);
+    }
+
+    println!("\nDevice: {}", device);
+    Ok(())
+}
+
 fn detect_model_format(model_path: &std::path::Path) -> Result<std::path::PathBuf> {
     if let Some(gguf) = find_file_with_extension(model_path, "gguf")? {
         Ok(gguf)
@@ -935,6 +1315,50 @@ fn extract_quantization(filename: &str) -> Option<String> {
     None
 }
 
+/// Details of an installed model, including what its KV cache costs.
+fn print_local_model_info(
+    config: &capi_core::Config,
+    registry: &capi_core::Registry,
+    model: &capi_core::db::ModelRecord,
+) -> Result<()> {
+    println!("\nModel: {} ({})", model.name, model.id);
+    println!("  Path: {}", model.path);
+    println!("  Type: {}", model.model_type);
+    if let Some(size) = model.size_bytes {
+        println!("  Size: {:.1} GB", size as f64 / 1_000_000_000.0);
+    }
+
+    if model.is_embedding() {
+        return Ok(());
+    }
+
+    let kv_cache = registry.kv_cache_settings_for(config, model);
+    let source = if model.kv_cache_precision.is_some() { "model override" } else { "config default" };
+    println!("  KV cache precision: {} ({})", kv_cache.precision, source);
+
+    let model_path = std::path::Path::new(&model.path);
+    let Some(per_token) = capi_core::InferenceSession::kv_bytes_per_token(model_path, &kv_cache)? else {
+        println!("  KV cache: unknown (no config.json with the model shape)");
+        return Ok(());
+    };
+
+    let context = registry.context_length_for(config, model);
+    println!("  KV cache per token: {:.1} KB", per_token as f64 / 1024.0);
+    // Budgets are in GiB, so KV sizes here are too
+    let gib = capi_core::model_manager::GIB as f64;
+    println!("  KV cache at {} tokens: {:.2} GiB", context, (per_token * context) as f64 / gib);
+    if let Some(budget_gb) = kv_cache.budget_gb {
+        let budget_bytes = budget_gb as u64 * capi_core::model_manager::GIB;
+        println!("  KV cache budget (server): {} GiB, ~{} tokens across requests", budget_gb, budget_bytes / per_token.max(1));
+    }
+
+    if let Some(size) = model.size_bytes {
+        let estimate = capi_core::model_manager::estimate_memory(size as u64, Some(per_token), context)?;
+        println!("  Estimated memory: {:.1} GiB", estimate.estimated_runtime_bytes as f64 / gib);
+    }
+    Ok(())
+}
+
 fn extract_quant_info(model_name: &str) -> Option<String> {
     let upper = model_name.to_uppercase();
     let mut quants = Vec::new();
@@ -2,7 +2,7 @@ use axum::{
     Json,
     response::{IntoResponse, Response, sse::{Event, Sse}},
     extract::State,
-    http::StatusCode,
+    http::{header, StatusCode},
 };
 use futures::stream::Stream;
 use serde::{Deserialize, Serialize};
@@ -10,16 +10,26 @@ use std::sync::Arc;
 use tokio::sync::RwLock;
 use std::convert::Infallible;
 
+use super::conversations::ConversationStore;
 use crate::model_manager::Registry;
-use crate::InferenceSession;
+use crate::inference::genai::{ChatMessage, GenerationConfig, GenerationEvent};
+use crate::scheduler::{ModelLoader, QueueFull, QueuePermit, RequestScheduler, ResidencyManager};
+use crate::{EmbeddingSession, InferenceMetrics, InferenceSession};
 use std::collections::HashMap;
 
-type ModelCache = Arc<RwLock<HashMap<String, Arc<RwLock<InferenceSession>>>>>;
+pub type ModelCache = Arc<RwLock<HashMap<String, Arc<RwLock<InferenceSession>>>>>;
+pub type EmbeddingCache = Arc<RwLock<HashMap<String, Arc<EmbeddingSession>>>>;
 
 #[derive(Clone)]
 pub struct AppState {
     pub registry: Arc<Registry>,
     pub model_cache: ModelCache,
+    pub embedding_cache: EmbeddingCache,
+    pub conversations: ConversationStore,
+    pub scheduler: RequestScheduler,
+    pub model_loader: ModelLoader<Arc<RwLock<InferenceSession>>>,
+    pub embedding_loader: ModelLoader<Arc<EmbeddingSession>>,
+    pub residency: Arc<ResidencyManager>,
 }
 
 #[derive(Deserialize)]
@@ -29,6 +39,56 @@ pub struct ChatCompletionRequest {
     pub stream: Option<bool>,
     pub temperature: Option<f32>,
     pub max_tokens: Option<usize>,
+    /// Extension: prompt-lookup decoding overrides. Only applies to models
+    /// registered with prompt lookup enabled; ignored otherwise.
+    #[serde(default)]
+    pub prompt_lookup: Option<PromptLookupOptions>,
+    /// Up to four sequences where generation stops; not included in the output
+    #[serde(default)]
+    pub stop: Option<StopSequences>,
+    /// Extension: LoRA adapter of the model to apply. `model` may also name
+    /// an adapter directly, which selects its base model.
+    #[serde(default)]
+    pub adapter: Option<String>,
+    /// Blend factor for the adapter; defaults to the one it was registered with
+    #[serde(default)]
+    pub adapter_alpha: Option<f32>,
+}
+
+#[derive(Deserialize, Clone)]
+#[serde(untagged)]
+pub enum StopSequences {
+    Single(String),
+    Multiple(Vec<String>),
+}
+
+impl StopSequences {
+    /// OpenAI accepts at most this many
+    pub const MAX: usize = 4;
+
+    /// Reject more sequences than OpenAI accepts.
+    pub fn validate(&self) -> anyhow::Result<()> {
+        let count = self.as_strs().len();
+        if count > Self::MAX {
+            return Err(anyhow::anyhow!("stop accepts at most {} sequences, got {}", Self::MAX, count));
+        }
+        Ok(())
+    }
+
+    pub fn as_strs(&self) -> Vec<&str> {
+        match self {
+            StopSequences::Single(stop) => vec![stop.as_str()],
+            StopSequences::Multiple(stops) => stops.iter().map(String::as_str).collect(),
+        }
+    }
+}
+
+#[derive(Deserialize, Default)]
+pub struct PromptLookupOptions {
+    /// Tokens copied from the prompt per step
+    pub num_assistant_tokens: Option<usize>,
+    /// Longest prompt n-gram to match
+    pub max_ngram_size: Option<usize>,
 }
 
 #[derive(Deserialize, Serialize, Clone)]
@@ -57,6 +117,38 @@ pub struct Usage {
     pub tokens_per_second: Option<f32>,
     #[serde(skip_serializing_if = "Option::is_none")]
     pub time_to_first_token_ms: Option<f32>,
+    /// Speculative decoding (draft model or prompt lookup): accepted draft
+    /// tokens. An estimate under continuous batching, and omitted there for
+    /// prompt lookup
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub accepted_tokens: Option<usize>,
+    /// Generated tokens per target-model decode step; an estimate likewise
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub speculative_speedup: Option<f32>,
+    /// Time waiting in the server queue and for the engine to admit the request
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub queue_time_ms: Option<f32>,
+    /// Admission to first token; long prompts are prefilled in chunks between decodes
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub prefill_time_ms: Option<f32>,
+}
+
+impl Usage {
+    pub fn from_metrics(metrics: &InferenceMetrics) -> Self {
+        let speculative = metrics.num_draft_tokens > 0;
+        let batched = metrics.prefill_time_ms > 0.0;
+        Self {
+            prompt_tokens: metrics.num_input_tokens,
+            completion_tokens: metrics.num_output_tokens,
+            total_tokens: metrics.num_input_tokens + metrics.num_output_tokens,
+            tokens_per_second: Some(metrics.tokens_per_second),
+            time_to_first_token_ms: Some(metrics.time_to_first_token_ms),
+            accepted_tokens: speculative.then_some(metrics.num_accepted_tokens),
+            speculative_speedup: speculative.then_some(metrics.speculative_speedup),
+            queue_time_ms: batched.then_some(metrics.queue_time_ms),
+            prefill_time_ms: batched.then_some(metrics.prefill_time_ms),
+        }
+    }
 }
 
 #[derive(Serialize)]
@@ -94,61 +186,212 @@ pub async fn completions(
 ) -> Response {
     let stream = payload.stream.unwrap_or(false);
 
-    if stream {
-        let stream = create_streaming_response(state, payload);
+    let Some(model_id) = payload.model.clone() else {
+        return (StatusCode::BAD_REQUEST, "Model is required").into_response();
+    };
+    if let Some(Err(e)) = payload.stop.as_ref().map(StopSequences::validate) {
+        return (StatusCode::BAD_REQUEST, e.to_string()).into_response();
+    }
+    let target = match resolve_model_target(&state, &model_id, payload.adapter.as_deref(), payload.adapter_alpha) {
+        Ok(target) => target,
+        Err(e) => return (StatusCode::BAD_REQUEST, e.to_string()).into_response(),
+    };
+    let permit = match state.scheduler.acquire(&target.base_model_id, 1).await {
+        Ok(permit) => permit,
+        Err(e) => return queue_full_response(&e),
+    };
+    let queue_time_ms = permit.queue_time().as_secs_f32() * 1000.0;
+
+    let response = if stream {
+        let stream = create_streaming_response(state, payload, model_id, target, permit);
         Sse::new(stream).into_response()
     } else {
-        match create_non_streaming_response(state, payload).await {
+        match create_non_streaming_response(state, payload, model_id, target, permit).await {
             Ok(response) => Json(response).into_response(),
             Err(e) => (StatusCode::INTERNAL_SERVER_ERROR, e.to_string()).into_response(),
         }
-    }
+    };
+    with_queue_time(response, queue_time_ms)
 }
 
-async fn create_non_streaming_response(
-    state: AppState,
-    payload: ChatCompletionRequest,
-) -> anyhow::Result<ChatCompletionResponse> {
-    let model_id = payload.model.as_ref()
-        .ok_or_else(|| anyhow::anyhow!("Model is required"))?;
+/// 429 with a Retry-After estimate for a request the model's queue turned away.
+pub(crate) fn queue_full_response(e: &QueueFull) -> Response {
+    (
+        StatusCode::TOO_MANY_REQUESTS,
+        [(header::RETRY_AFTER, e.retry_after_secs.to_string())],
+        e.to_string(),
+    ).into_response()
+}
 
-    let mut cache = state.model_cache.write().await;
+/// Report the server-side queue wait, which streaming responses have no usage block for.
+pub(crate) fn with_queue_time(mut response: Response, queue_time_ms: f32) -> Response {
+    if let Ok(value) = format!("{:.1}", queue_time_ms).parse() {
+        response.headers_mut().insert("x-queue-time-ms", value);
+    }
+    response
+}
 
-    let session = if let Some(cached_session) = cache.get(model_id) {
-        Arc::clone(cached_session)
-    } else {
-        let model = state.registry.get_model(model_id)?
-            .ok_or_else(|| anyhow::anyhow!("Model not found: {}", model_id))?;
+/// Return the cached session for a model, loading it on first use.
+/// Concurrent requests for a cold model share one load.
+pub(crate) async fn get_or_load_session(
+    state: &AppState,
+    model_id: &str,
+) -> anyhow::Result<Arc<RwLock<InferenceSession>>> {
+    let registry = Arc::clone(&state.registry);
+    let residency = Arc::clone(&state.residency);
+    let owned_id = model_id.to_string();
+
+    let session = state.model_loader.get_or_load(&state.model_cache, model_id, move || {
+        let model_id = owned_id;
+        let Some(model) = registry.get_model(&model_id)? else {
+            if registry.get_adapter(&model_id)?.is_some() {
+                return Err(anyhow::anyhow!("{} is a LoRA adapter; use /v1/chat/completions", model_id));
+            }
+            return Err(anyhow::anyhow!("Model not found: {}", model_id));
+        };
+        if model.is_embedding() {
+            return Err(anyhow::anyhow!("{} is an embedding model; use /v1/embeddings", model_id));
+        }
 
         let config = crate::Config::load()?;
         let devices = crate::hardware::detect_devices()?;
         let device = crate::hardware::select_best_device(&devices, &config.device_preference)
             .unwrap_or_else(|| "CPU".to_string());
 
+        let speculative = registry.speculative_config_for(&config, &model, &device)?;
+        let kv_cache = registry.kv_cache_settings_for(&config, &model);
+        let adapters = registry.lora_adapters_for(&model)?;
+        // Every replica holds its own copy of the weights, so load no more
+        // than the machine has room for
+        let configured = registry.replicas_for(&config, &model);
+        let replicas = crate::hardware::detect_system_resources()
+            .map(|resources| registry.replicas_within(&config, &model, resources.available_ram_bytes))
+            .unwrap_or(configured);
+        if replicas < configured {
+            eprintln!("Loading {} with {} of {} replicas; more would not fit in available RAM", model_id, replicas, configured);
+        }
+
+        residency.reserve(&model_id, registry.replica_memory_bytes(&config, &model, replicas))?;
         let model_path = std::path::Path::new(&model.path);
-        let loaded_session = crate::InferenceSession::load(model_path, &device)?;
-        let session_arc = Arc::new(RwLock::new(loaded_session));
+        let loaded_session = crate::InferenceSession::load_batched(model_path, &device, &speculative, &kv_cache, &adapters, replicas)
+            .inspect_err(|_| residency.release(&model_id))?;
+        Ok(Arc::new(RwLock::new(loaded_session)))
+    }).await?;
+
+    state.residency.touch(model_id);
+    Ok(session)
+}
 
-        cache.insert(model_id.clone(), Arc::clone(&session_arc));
-        session_arc
+/// The base model a request runs on and the adapter it selects.
+pub(crate) struct ModelTarget {
+    pub base_model_id: String,
+    pub adapter: Option<(String, f32)>,
+}
+
+/// Resolve `model` (a model or adapter id) and an explicit adapter choice.
+pub(crate) fn resolve_model_target(
+    state: &AppState,
+    model: &str,
+    adapter: Option<&str>,
+    alpha: Option<f32>,
+) -> anyhow::Result<ModelTarget> {
+    if let Some(record) = state.registry.get_adapter(model)? {
+        if adapter.is_some_and(|name| name != record.id) {
+            return Err(anyhow::anyhow!("{} is an adapter; it cannot be combined with adapter {}", model, adapter.unwrap_or_default()));
+        }
+        return Ok(ModelTarget {
+            base_model_id: record.base_model_id,
+            adapter: Some((record.id, alpha.unwrap_or(record.alpha as f32))),
+        });
+    }
+
+    let adapter = match adapter {
+        Some(name) => {
+            let record = state.registry.get_adapter(name)?
+                .filter(|record| record.base_model_id == model)
+                .ok_or_else(|| anyhow::anyhow!("Adapter {} not found for model {}", name, model))?;
+            Some((record.id, alpha.unwrap_or(record.alpha as f32)))
+        }
+        None => None,
     };
+    Ok(ModelTarget {
+        base_model_id: model.to_string(),
+        adapter,
+    })
+}
 
-    drop(cache);
+/// Generation settings for a request, including its prompt-lookup overrides
+/// and adapter.
+fn generation_config(payload: &ChatCompletionRequest, target: &ModelTarget, session: &InferenceSession) -> anyhow::Result<GenerationConfig> {
+    let mut config = GenerationConfig::new()?;
+    config.set_max_new_tokens(payload.max_tokens.unwrap_or(4096))?;
 
-    let mut session_guard = session.write().await;
+    if let Some((name, alpha)) = &target.adapter {
+        if !session.has_adapter(name) {
+            return Err(anyhow::anyhow!("Adapter {} was registered after the model was loaded; restart the server to use it", name));
+        }
+        config.set_adapter(name, *alpha)?;
+    }
 
-    let conversation: String = payload.messages.iter()
-        .map(|m| format!("{}: {}",
-            if m.role == "user" { "User" } else { "Assistant" },
-            m.content
-        ))
-        .collect::<Vec<_>>()
-        .join("\n");
+    // EOS and the model's end-of-turn tokens are added by the bridge
+    if let Some(stop) = &payload.stop {
+        let stops = stop.as_strs();
+        if !stops.is_empty() {
+            config.set_stop_strings(&stops)?;
+        }
+    }
 
-    let full_prompt = conversation + "\nAssistant:";
-    let max_tokens = payload.max_tokens.unwrap_or(4096);
+    if let Some(options) = payload.prompt_lookup.as_ref().filter(|_| session.is_prompt_lookup()) {
+        if let Some(num_tokens) = options.num_assistant_tokens {
+            config.set_num_assistant_tokens(num_tokens)?;
+        }
+        if let Some(max_ngram_size) = options.max_ngram_size {
+            config.set_max_ngram_size(max_ngram_size)?;
+        }
+    }
 
-    let (response_text, metrics) = session_guard.generate_with_metrics(&full_prompt, max_tokens)?;
+    Ok(config)
+}
+
+/// Request messages as passed to the model's chat template.
+fn chat_messages(messages: &[Message]) -> Vec<ChatMessage> {
+    messages.iter()
+        .map(|m| ChatMessage {
+            role: m.role.clone(),
+            content: m.content.clone(),
+        })
+        .collect()
+}
+
+async fn create_non_streaming_response(
+    state: AppState,
+    payload: ChatCompletionRequest,
+    model_id: String,
+    target: ModelTarget,
+    permit: QueuePermit,
+) -> anyhow::Result<ChatCompletionResponse> {
+    let session = get_or_load_session(&state, &target.base_model_id).await?;
+
+    // Submitting only needs a read lock; the engine batches concurrent requests
+    let mut events = {
+        let session = session.read().await;
+        let config = generation_config(&payload, &target, &session)?;
+        session.submit_chat(chat_messages(&payload.messages), config)?
+    };
+
+    let (response_text, metrics, finish_reason) = loop {
+        match events.recv().await {
+            Some(GenerationEvent::Token(_)) => {}
+            Some(GenerationEvent::Finished { result, finish_reason }) => {
+                break (result.text, InferenceMetrics::from(&result.metrics), finish_reason);
+            }
+            Some(GenerationEvent::Failed(e)) => return Err(anyhow::anyhow!("Generation failed: {}", e)),
+            None => return Err(anyhow::anyhow!("Generation failed: engine dropped the request")),
+        }
+    };
+    let mut metrics = metrics;
+    metrics.queue_time_ms += permit.queue_time().as_secs_f32() * 1000.0;
+    drop(permit);
 
     let timestamp = std::time::SystemTime::now()
         .duration_since(std::time::UNIX_EPOCH)?
@@ -158,134 +401,84 @@ async fn create_non_streaming_response(
         id: format!("chatcmpl-{}", uuid::Uuid::new_v4()),
         object: "chat.completion".to_string(),
         created: timestamp,
-        model: model_id.clone(),
+        model: model_id,
         choices: vec![Choice {
             index: 0,
             message: Message {
                 role: "assistant".to_string(),
                 content: response_text,
             },
-            finish_reason: "stop".to_string(),
+            finish_reason,
         }],
-        usage: Some(Usage {
-            prompt_tokens: metrics.num_input_tokens,
-            completion_tokens: metrics.num_output_tokens,
-            total_tokens: metrics.num_input_tokens + metrics.num_output_tokens,
-            tokens_per_second: Some(metrics.tokens_per_second),
-            time_to_first_token_ms: Some(metrics.time_to_first_token_ms),
-        }),
+        usage: Some(Usage::from_metrics(&metrics)),
     })
 }
 
 fn create_streaming_response(
     state: AppState,
     payload: ChatCompletionRequest,
+    model_id: String,
+    target: ModelTarget,
+    permit: QueuePermit,
 ) -> impl Stream<Item = Result<Event, Infallible>> {
     use async_stream::stream;
-    use tokio::sync::mpsc;
 
     stream! {
-        let model_id = match payload.model.as_ref() {
-            Some(id) => id.clone(),
-            None => return,
-        };
-
-        let mut cache = state.model_cache.write().await;
-
-        let session = if let Some(cached_session) = cache.get(&model_id) {
-            Arc::clone(cached_session)
-        } else {
-            let model = match state.registry.get_model(&model_id) {
-                Ok(Some(m)) => m,
-                _ => return,
-            };
-
-            let config = match crate::Config::load() {
-                Ok(c) => c,
-                Err(_) => return,
-            };
-
-            let devices = match crate::hardware::detect_devices() {
-                Ok(d) => d,
-                Err(_) => return,
-            };
-
-            let device = crate::hardware::select_best_device(&devices, &config.device_preference)
-                .unwrap_or_else(|| "CPU".to_string());
-
-            let model_path = std::path::Path::new(&model.path);
-            let loaded_session = match crate::InferenceSession::load(model_path, &device) {
-                Ok(s) => s,
-                Err(_) => return,
-            };
-
-            let session_arc = Arc::new(RwLock::new(loaded_session));
-            cache.insert(model_id.clone(), Arc::clone(&session_arc));
-            session_arc
+        // Slots are held until the stream ends or the client goes away
+        let _permit = permit;
+
+        let session = match get_or_load_session(&state, &target.base_model_id).await {
+            Ok(s) => s,
+            Err(e) => {
+                yield Ok(stream_error(&e.to_string()));
+                return;
+            }
         };
 
-        drop(cache);
-
-        // We don't need to hold the lock here, as spawn_blocking will acquire its own.
-        // Holding it here would cause a deadlock with blocking_write below.
-        
-        let conversation: String = payload.messages.iter()
-            .map(|m| format!("{}: {}", if m.role == "user" { "User" } else { "Assistant" }, m.content))
-            .collect::<Vec<_>>()
-            .join("\n");
-
-        let full_prompt = conversation + "\nAssistant:";
-        let max_tokens = payload.max_tokens.unwrap_or(4096);
-
         let timestamp = std::time::SystemTime::now()
             .duration_since(std::time::UNIX_EPOCH)
             .unwrap_or_default()
             .as_secs() as i64;
 
         let id = format!("chatcmpl-{}", uuid::Uuid::new_v4());
-        let id_clone = id.clone();
-        let model_clone = model_id.clone();
+        let template = ChunkTemplate::new(&id, timestamp, &model_id);
 
-        let (tx, mut rx) = mpsc::unbounded_channel();
-
-        let session_clone = Arc::clone(&session);
-        let prompt_clone = full_prompt.clone();
-
-        tokio::task::spawn_blocking(move || {
-            let mut session_guard = session_clone.blocking_write();
-            session_guard.generate_stream(&prompt_clone, max_tokens, move |token| {
-                tx.send(token.to_string()).ok();
-                true
-            })
-        });
+        // Submitting only needs a read lock; the engine batches concurrent requests
+        let submitted = {
+            let session = session.read().await;
+            generation_config(&payload, &target, &session)
+                .and_then(|config| session.submit_chat(chat_messages(&payload.messages), config))
+        };
+        let mut events = match submitted {
+            Ok(events) => events,
+            Err(e) => {
+                yield Ok(stream_error(&e.to_string()));
+                return;
+            }
+        };
 
         let mut is_first = true;
 
-        while let Some(token) = rx.recv().await {
-            let chunk = ChatCompletionChunk {
-                id: id_clone.clone(),
-                object: "chat.completion.chunk".to_string(),
-                created: timestamp,
-                model: model_clone.clone(),
-                choices: vec![ChunkChoice {
-                    index: 0,
-                    delta: Delta {
-                        role: if is_first { Some("assistant".to_string()) } else { None },
-                        content: Some(token),
-                    },
-                    finish_reason: None,
-                }],
+        // A failure ends the stream with an error event rather than a finish reason
+        let finish_reason = loop {
+            let token = match events.recv().await {
+                Some(GenerationEvent::Token(token)) => token,
+                Some(GenerationEvent::Finished { finish_reason, .. }) => break finish_reason,
+                Some(GenerationEvent::Failed(e)) => {
+                    yield Ok(stream_error(&e));
+                    return;
+                }
+                None => {
+                    yield Ok(stream_error("Generation ended without a result"));
+                    return;
+                }
             };
 
+            let json = template.render(&token, is_first);
             is_first = false;
 
-            if let Ok(json) = serde_json::to_string(&chunk) {
-                yield Ok(Event::default().data(json));
-            }
-        }
-
-        // drop(session_guard); - removed as not acquired
-
+            yield Ok(Event::default().data(json));
+        };
 
         let final_chunk = ChatCompletionChunk {
             id: id.clone(),
@@ -298,7 +491,7 @@ fn create_streaming_response(
                     role: None,
                     content: None,
                 },
-                finish_reason: Some("stop".to_string()),
+                finish_reason: Some(finish_reason),
             }],
         };
 
@@ -308,9 +501,69 @@ fn create_streaming_response(
     }
 }
 
-pub async fn completions_legacy(
-    state: State<AppState>,
-    Json(payload): Json<ChatCompletionRequest>,
-) -> Response {
-    completions(state, Json(payload)).await
+/// OpenAI-style error object, sent in place of a chunk when a stream fails.
+fn stream_error(message: &str) -> Event {
+    let error = serde_json::json!({
+        "error": {
+            "message": message,
+            "type": "server_error",
+        }
+    });
+    Event::default().data(error.to_string())
+}
+
+/// Pre-rendered JSON around a chunk's delta, so each streamed token costs one
+/// buffer instead of building and serializing a `ChatCompletionChunk`.
+/// Output matches the serde form of `ChatCompletionChunk`.
+struct ChunkTemplate {
+    prefix: String,
+}
+
+impl ChunkTemplate {
+    fn new(id: &str, created: i64, model: &str) -> Self {
+        let mut prefix = String::with_capacity(128 + id.len() + model.len());
+        prefix.push_str("{\"id\":");
+        push_json_string(&mut prefix, id);
+        prefix.push_str(",\"object\":\"chat.completion.chunk\",\"created\":");
+        prefix.push_str(&created.to_string());
+        prefix.push_str(",\"model\":");
+        push_json_string(&mut prefix, model);
+        prefix.push_str(",\"choices\":[{\"index\":0,\"delta\":{\"role\":");
+        Self { prefix }
+    }
+
+    fn render(&self, content: &str, is_first: bool) -> String {
+        const SUFFIX: &str = "},\"finish_reason\":null}]}";
+        let role = if is_first { "\"assistant\"" } else { "null" };
+
+        let mut out = String::with_capacity(self.prefix.len() + role.len() + content.len() + 16 + SUFFIX.len());
+        out.push_str(&self.prefix);
+        out.push_str(role);
+        out.push_str(",\"content\":");
+        push_json_string(&mut out, content);
+        out.push_str(SUFFIX);
+        out
+    }
+}
+
+fn push_json_string(out: &mut String, s: &str) {
+    use std::fmt::Write;
+
+    out.push('"');
+    for c in s.chars() {
+        match c {
+            '"' => out.push_str("\\\""),
+            '\\' => out.push_str("\\\\"),
+            '\n' => out.push_str("\\n"),
+            '\r' => out.push_str("\\r"),
+            '\t' => out.push_str("\\t"),
+            '\u{08}' => out.push_str("\\b"),
+            '\u{0c}' => out.push_str("\\f"),
+            c if (c as u32) < 0x20 => {
+                write!(out, "\\u{:04x}", c as u32).ok();
+            }
+            c => out.push(c),
+        }
+    }
+    out.push('"');
 }
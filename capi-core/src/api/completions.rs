@@ -0,0 +1,176 @@
+use axum::{
+    Json,
+    response::{IntoResponse, Response},
+    extract::State,
+    http::StatusCode,
+};
+use serde::{Deserialize, Serialize};
+
+use crate::inference::BatchCompletion;
+use super::chat::{self, AppState, ChatCompletionRequest, Message, ModelTarget, StopSequences, Usage};
+
+#[derive(Deserialize)]
+pub struct CompletionRequest {
+    pub model: Option<String>,
+    pub prompt: Option<CompletionPrompt>,
+    /// Older clients post chat payloads to /v1/completions
+    pub messages: Option<Vec<Message>>,
+    pub stream: Option<bool>,
+    pub temperature: Option<f32>,
+    pub max_tokens: Option<usize>,
+    #[serde(default)]
+    pub stop: Option<StopSequences>,
+    #[serde(default)]
+    pub adapter: Option<String>,
+    #[serde(default)]
+    pub adapter_alpha: Option<f32>,
+}
+
+#[derive(Deserialize)]
+#[serde(untagged)]
+pub enum CompletionPrompt {
+    Single(String),
+    Multiple(Vec<String>),
+}
+
+#[derive(Serialize)]
+pub struct CompletionResponse {
+    pub id: String,
+    pub object: String,
+    pub created: i64,
+    pub model: String,
+    pub choices: Vec<CompletionChoice>,
+    pub usage: Usage,
+}
+
+#[derive(Serialize)]
+pub struct CompletionChoice {
+    pub text: String,
+    pub index: usize,
+    pub finish_reason: String,
+}
+
+pub async fn create(
+    state: State<AppState>,
+    Json(payload): Json<CompletionRequest>,
+) -> Response {
+    let prompts = match payload.prompt {
+        Some(CompletionPrompt::Single(prompt)) => vec![prompt],
+        Some(CompletionPrompt::Multiple(prompts)) => prompts,
+        None => {
+            let Some(messages) = payload.messages else {
+                return (StatusCode::BAD_REQUEST, "Either prompt or messages is required").into_response();
+            };
+            let request = ChatCompletionRequest {
+                model: payload.model,
+                messages,
+                stream: payload.stream,
+                temperature: payload.temperature,
+                max_tokens: payload.max_tokens,
+                prompt_lookup: None,
+                stop: payload.stop,
+                adapter: payload.adapter,
+                adapter_alpha: payload.adapter_alpha,
+            };
+            return chat::completions(state, Json(request)).await;
+        }
+    };
+
+    if payload.stream.unwrap_or(false) {
+        return (StatusCode::BAD_REQUEST, "Streaming is only supported on /v1/chat/completions").into_response();
+    }
+
+    let model_id = match payload.model {
+        Some(id) => id,
+        None => return (StatusCode::BAD_REQUEST, "Model is required").into_response(),
+    };
+
+    if let Some(Err(e)) = payload.stop.as_ref().map(StopSequences::validate) {
+        return (StatusCode::BAD_REQUEST, e.to_string()).into_response();
+    }
+    let stop = payload.stop.as_ref()
+        .map(|stop| stop.as_strs().into_iter().map(str::to_string).collect())
+        .unwrap_or_default();
+
+    let target = match chat::resolve_model_target(&state, &model_id, payload.adapter.as_deref(), payload.adapter_alpha) {
+        Ok(target) => target,
+        Err(e) => return (StatusCode::BAD_REQUEST, e.to_string()).into_response(),
+    };
+
+    // Each prompt is a sequence in the batch, so it takes its own slot
+    let permit = match state.scheduler.acquire(&target.base_model_id, prompts.len()).await {
+        Ok(permit) => permit,
+        Err(e) => return chat::queue_full_response(&e),
+    };
+    let queue_time_ms = permit.queue_time().as_secs_f32() * 1000.0;
+
+    let response = match create_response(&state, model_id, target, prompts, payload.max_tokens.unwrap_or(4096), stop, queue_time_ms).await {
+        Ok(response) => Json(response).into_response(),
+        Err(e) => (StatusCode::INTERNAL_SERVER_ERROR, e.to_string()).into_response(),
+    };
+    drop(permit);
+    chat::with_queue_time(response, queue_time_ms)
+}
+
+async fn create_response(
+    state: &AppState,
+    model_id: String,
+    target: ModelTarget,
+    prompts: Vec<String>,
+    max_tokens: usize,
+    stop: Vec<String>,
+    queue_time_ms: f32,
+) -> anyhow::Result<CompletionResponse> {
+    let session = chat::get_or_load_session(state, &target.base_model_id).await?;
+
+    // All prompts go in as one batch rather than N sequential generations.
+    // Submitting only needs a read lock; the results arrive on async streams,
+    // so no thread is held while the engine works.
+    let streams = {
+        let prompts: Vec<&str> = prompts.iter().map(String::as_str).collect();
+        let stop: Vec<&str> = stop.iter().map(String::as_str).collect();
+        let adapter = target.adapter.as_ref().map(|(name, alpha)| (name.as_str(), *alpha));
+        session.read().await.submit_batch(&prompts, max_tokens, &stop, adapter)?
+    };
+    let outputs = futures::future::try_join_all(streams.into_iter().map(BatchCompletion::collect)).await?;
+
+    let timestamp = std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)?
+        .as_secs() as i64;
+
+    // The batch is answered once its last prompt is admitted
+    let engine_queue_ms = outputs.iter()
+        .map(|output| output.metrics.queue_time_ms)
+        .fold(0.0, f32::max);
+
+    let mut prompt_tokens = 0;
+    let mut completion_tokens = 0;
+    let choices = outputs.into_iter().enumerate().map(|(index, output)| {
+        prompt_tokens += output.metrics.num_input_tokens;
+        completion_tokens += output.metrics.num_output_tokens;
+        CompletionChoice {
+            text: output.text,
+            index,
+            finish_reason: output.finish_reason,
+        }
+    }).collect();
+
+    Ok(CompletionResponse {
+        id: format!("cmpl-{}", uuid::Uuid::new_v4()),
+        object: "text_completion".to_string(),
+        created: timestamp,
+        model: model_id,
+        choices,
+        usage: Usage {
+            prompt_tokens,
+            completion_tokens,
+            total_tokens: prompt_tokens + completion_tokens,
+            tokens_per_second: None,
+            time_to_first_token_ms: None,
+            accepted_tokens: None,
+            speculative_speedup: None,
+            queue_time_ms: Some(queue_time_ms + engine_queue_ms),
+            prefill_time_ms: None,
+        },
+    })
+}
@@ -0,0 +1,624 @@
+//! Server-held conversations.
+//!
+//! A conversation lives in the `chat_sessions`/`chat_messages` tables and,
+//! while it is live, owns a chat-mode pipeline whose KV cache already holds
+//! the history. Clients post only the new user message, so neither the
+//! history upload nor its prefill is repeated each turn. The pipeline is a
+//! compiled model of its own, so each live conversation is charged its
+//! weights and KV cache against the residency budget. Conversations that are
+//! not live (evicted, out of memory, or from an earlier server run) are
+//! answered by the model's shared batching engine from the stored history.
+
+use axum::{
+    Json,
+    response::{IntoResponse, Response, sse::{Event, Sse}},
+    extract::{Path, State, ws::{Message as WsMessage, WebSocket, WebSocketUpgrade}},
+    http::StatusCode,
+};
+use futures::StreamExt;
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::convert::Infallible;
+use std::sync::{Arc, Weak};
+use std::time::{Duration, Instant};
+use tokio::sync::{mpsc, Mutex, OwnedMutexGuard};
+
+use super::chat::{self, AppState, Message, Usage};
+use super::stats::MemoryStats;
+use crate::db::{self, Database};
+use crate::hardware::detect_system_resources;
+use crate::inference::genai::{ChatMessage, GenerationConfig, GenerationEvent, SpeculativeConfig};
+use crate::inference::SessionMemory;
+use crate::scheduler::ResidencyManager;
+use crate::{Config, InferenceMetrics, InferenceSession};
+
+type LiveMap = Mutex<HashMap<String, LiveConversation>>;
+
+/// Stored conversations plus the ones currently pinned to a pipeline.
+#[derive(Clone)]
+pub struct ConversationStore {
+    db: Arc<Database>,
+    config: Arc<Config>,
+    residency: Arc<ResidencyManager>,
+    live: Arc<LiveMap>,
+    /// One turn at a time per conversation; entries expire with the last turn holding them
+    turns: Arc<std::sync::Mutex<HashMap<String, Weak<Mutex<()>>>>>,
+}
+
+struct LiveConversation {
+    session: Arc<Mutex<InferenceSession>>,
+    last_used: Instant,
+}
+
+impl ConversationStore {
+    /// Create the store; inside a Tokio runtime this also starts the idle sweeper.
+    pub fn new(db: Arc<Database>, config: Config, residency: Arc<ResidencyManager>) -> Self {
+        let store = Self {
+            db,
+            config: Arc::new(config),
+            residency,
+            live: Arc::new(Mutex::new(HashMap::new())),
+            turns: Arc::new(std::sync::Mutex::new(HashMap::new())),
+        };
+
+        if let Ok(runtime) = tokio::runtime::Handle::try_current() {
+            let timeout = Duration::from_secs(store.config.conversations.idle_timeout_secs);
+            runtime.spawn(sweep_idle(Arc::downgrade(&store.live), Arc::clone(&store.residency), timeout));
+        }
+
+        store
+    }
+
+    fn conversation(&self, id: &str) -> anyhow::Result<Option<db::ChatSession>> {
+        self.db.with_connection(|conn| db::chats::get_session(conn, id))
+    }
+
+    fn messages(&self, id: &str) -> anyhow::Result<Vec<db::ChatMessage>> {
+        self.db.with_connection(|conn| db::chats::get_messages(conn, id))
+    }
+
+    fn append(&self, conversation: &db::ChatSession, role: &str, content: &str) -> anyhow::Result<()> {
+        let now = unix_now();
+        let message = db::ChatMessage {
+            id: uuid::Uuid::new_v4().to_string(),
+            session_id: conversation.id.clone(),
+            role: role.to_string(),
+            content: content.to_string(),
+            created_at: now,
+        };
+        let updated = db::ChatSession {
+            updated_at: now,
+            ..conversation.clone()
+        };
+
+        self.db.with_connection(|conn| {
+            db::chats::add_message(conn, &message)?;
+            db::chats::update_session(conn, &updated)
+        })
+    }
+
+    /// Wait for earlier turns of the conversation, so its messages and answers
+    /// are stored and generated in order.
+    async fn lock_turn(&self, id: &str) -> OwnedMutexGuard<()> {
+        let lock = {
+            let mut turns = self.turns.lock().unwrap();
+            turns.retain(|_, lock| lock.strong_count() > 0);
+            match turns.get(id).and_then(Weak::upgrade) {
+                Some(lock) => lock,
+                None => {
+                    let lock = Arc::new(Mutex::new(()));
+                    turns.insert(id.to_string(), Arc::downgrade(&lock));
+                    lock
+                }
+            }
+        };
+        lock.lock_owned().await
+    }
+
+    async fn is_live(&self, id: &str) -> bool {
+        self.live.lock().await.contains_key(id)
+    }
+
+    /// Memory of the conversation's live pipeline, unless it is busy generating.
+    async fn memory(&self, id: &str) -> Option<SessionMemory> {
+        let session = Arc::clone(&self.live.lock().await.get(id)?.session);
+        let session = session.try_lock().ok()?;
+        Some(session.memory_usage())
+    }
+
+    async fn evict(&self, id: &str) {
+        let removed = self.live.lock().await.remove(id);
+        unload(&self.residency, removed.map(|conversation| (id.to_string(), conversation)));
+    }
+
+    /// The live pipeline for a conversation, if it has one or can get one.
+    ///
+    /// Only a conversation with no turns yet gets a new pipeline; one with
+    /// history the pipeline never saw stays on the shared engine. So does one
+    /// whose pipeline would not fit in memory: it is charged to the residency
+    /// budget, or without a budget must fit in the memory the system has free.
+    /// Callers hold the conversation's turn lock.
+    async fn checkout(
+        &self,
+        state: &AppState,
+        id: &str,
+        model: &db::ModelRecord,
+        system_message: &str,
+        is_new: bool,
+    ) -> anyhow::Result<Option<Arc<Mutex<InferenceSession>>>> {
+        {
+            let mut live = self.live.lock().await;
+            if let Some(conversation) = live.get_mut(id) {
+                conversation.last_used = Instant::now();
+                return Ok(Some(Arc::clone(&conversation.session)));
+            }
+            if !is_new {
+                return Ok(None);
+            }
+            match make_room(&mut live, self.config.conversations.max_live) {
+                Some(evicted) => unload(&self.residency, evicted),
+                None => return Ok(None),
+            }
+        }
+
+        let config = &self.config;
+        let devices = crate::hardware::detect_devices()?;
+        let device = crate::hardware::select_best_device(&devices, &config.device_preference)
+            .unwrap_or_else(|| "CPU".to_string());
+
+        let bytes = state.registry.conversation_memory_bytes(config, model, config.conversations.max_context_tokens);
+        let budgeted = config.residency.memory_budget_gb.is_some();
+        let kv_cache = state.registry.kv_cache_settings_for(config, model);
+        let model_path = model.path.clone();
+        let system_message = system_message.to_string();
+        let residency = Arc::clone(&self.residency);
+        let conversation_id = id.to_string();
+        let session = tokio::task::spawn_blocking(move || -> anyhow::Result<Option<InferenceSession>> {
+            if budgeted {
+                if let Err(e) = residency.reserve_conversation(&conversation_id, bytes) {
+                    eprintln!("Conversation {} stays on the shared engine: {}", conversation_id, e);
+                    return Ok(None);
+                }
+            } else if detect_system_resources().is_ok_and(|resources| resources.available_ram_bytes < bytes) {
+                return Ok(None);
+            }
+
+            let model_path = std::path::Path::new(&model_path);
+            let loaded = InferenceSession::load_speculative(model_path, &device, &SpeculativeConfig::default(), &kv_cache, &[])
+                .and_then(|mut session| {
+                    session.start_chat_with_system(&system_message)?;
+                    Ok(session)
+                });
+            if loaded.is_err() {
+                residency.release_conversation(&conversation_id);
+            }
+            loaded.map(Some)
+        }).await??;
+
+        let Some(session) = session else {
+            return Ok(None);
+        };
+        let session = Arc::new(Mutex::new(session));
+        self.live.lock().await.insert(id.to_string(), LiveConversation {
+            session: Arc::clone(&session),
+            last_used: Instant::now(),
+        });
+        Ok(Some(session))
+    }
+}
+
+/// Free a slot for one more live conversation by evicting the least recently
+/// used idle one; returns what was evicted. None if every live conversation is
+/// mid-generation.
+fn make_room(live: &mut HashMap<String, LiveConversation>, max_live: usize) -> Option<Option<(String, LiveConversation)>> {
+    if live.len() < max_live {
+        return Some(None);
+    }
+
+    let oldest_idle = live.iter()
+        .filter(|(_, conversation)| conversation.session.try_lock().is_ok())
+        .min_by_key(|(_, conversation)| conversation.last_used)
+        .map(|(id, _)| id.clone())?;
+
+    let conversation = live.remove(&oldest_idle)?;
+    Some(Some((oldest_idle, conversation)))
+}
+
+/// Release the residency charge of evicted conversations and drop their
+/// pipelines on a blocking thread, as freeing a compiled model takes a while.
+fn unload(residency: &ResidencyManager, evicted: impl IntoIterator<Item = (String, LiveConversation)>) {
+    let sessions: Vec<_> = evicted.into_iter()
+        .map(|(id, conversation)| {
+            residency.release_conversation(&id);
+            conversation.session
+        })
+        .collect();
+    if !sessions.is_empty() {
+        tokio::task::spawn_blocking(move || drop(sessions));
+    }
+}
+
+async fn sweep_idle(live: Weak<LiveMap>, residency: Arc<ResidencyManager>, timeout: Duration) {
+    let mut interval = tokio::time::interval(Duration::from_secs(30));
+    loop {
+        interval.tick().await;
+        let Some(live) = live.upgrade() else {
+            return;
+        };
+
+        let expired: Vec<_> = {
+            let mut live = live.lock().await;
+            let ids: Vec<String> = live.iter()
+                .filter(|(_, conversation)| conversation.last_used.elapsed() >= timeout && conversation.session.try_lock().is_ok())
+                .map(|(id, _)| id.clone())
+                .collect();
+            ids.into_iter()
+                .filter_map(|id| live.remove(&id).map(|conversation| (id, conversation)))
+                .collect()
+        };
+        unload(&residency, expired);
+    }
+}
+
+#[derive(Deserialize)]
+pub struct CreateConversationRequest {
+    pub model: String,
+    /// System prompt for the whole conversation
+    pub system: Option<String>,
+    pub title: Option<String>,
+}
+
+#[derive(Deserialize)]
+pub struct MessageRequest {
+    pub content: String,
+    pub stream: Option<bool>,
+    pub max_tokens: Option<usize>,
+}
+
+#[derive(Serialize)]
+pub struct Conversation {
+    pub id: String,
+    pub object: String,
+    pub created: i64,
+    pub model: Option<String>,
+    pub title: Option<String>,
+    /// Whether a pipeline currently holds this conversation's KV cache
+    pub live: bool,
+    /// Memory of the live pipeline; omitted when not live or mid-generation
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub memory: Option<MemoryStats>,
+    #[serde(skip_serializing_if = "Vec::is_empty")]
+    pub messages: Vec<Message>,
+}
+
+#[derive(Serialize)]
+pub struct MessageResponse {
+    pub conversation_id: String,
+    pub message: Message,
+    pub finish_reason: String,
+    pub usage: Usage,
+}
+
+#[derive(Serialize)]
+pub struct DeletedConversation {
+    pub id: String,
+    pub object: String,
+    pub deleted: bool,
+}
+
+/// One event of a turn, as sent over SSE and WebSocket.
+#[derive(Serialize)]
+#[serde(tag = "type", rename_all = "snake_case")]
+enum TurnEvent {
+    Token { content: String },
+    Done { finish_reason: String, usage: Usage },
+    Error { message: String },
+}
+
+pub async fn create(
+    State(state): State<AppState>,
+    Json(payload): Json<CreateConversationRequest>,
+) -> Response {
+    match create_conversation(&state, payload) {
+        Ok(conversation) => Json(conversation).into_response(),
+        Err(e) => (StatusCode::BAD_REQUEST, e.to_string()).into_response(),
+    }
+}
+
+fn create_conversation(state: &AppState, payload: CreateConversationRequest) -> anyhow::Result<Conversation> {
+    let model = state.registry.get_model(&payload.model)?
+        .ok_or_else(|| anyhow::anyhow!("Model not found: {}", payload.model))?;
+    if model.is_embedding() {
+        return Err(anyhow::anyhow!("{} is an embedding model", payload.model));
+    }
+
+    let now = unix_now();
+    let conversation = db::ChatSession {
+        id: format!("conv-{}", uuid::Uuid::new_v4()),
+        title: Some(payload.title.unwrap_or_else(|| "New Chat".to_string())),
+        model_id: Some(model.id),
+        created_at: now,
+        updated_at: now,
+    };
+
+    let store = &state.conversations;
+    store.db.with_connection(|conn| db::chats::create_session(conn, &conversation))?;
+    if let Some(system) = payload.system.filter(|s| !s.is_empty()) {
+        store.append(&conversation, "system", &system)?;
+    }
+
+    Ok(Conversation {
+        id: conversation.id,
+        object: "conversation".to_string(),
+        created: conversation.created_at,
+        model: conversation.model_id,
+        title: conversation.title,
+        live: false,
+        memory: None,
+        messages: Vec::new(),
+    })
+}
+
+pub async fn get(
+    State(state): State<AppState>,
+    Path(id): Path<String>,
+) -> Response {
+    let store = &state.conversations;
+    let (conversation, messages) = match store.conversation(&id).and_then(|c| Ok((c, store.messages(&id)?))) {
+        Ok((Some(conversation), messages)) => (conversation, messages),
+        Ok((None, _)) => return (StatusCode::NOT_FOUND, "Conversation not found").into_response(),
+        Err(e) => return (StatusCode::INTERNAL_SERVER_ERROR, e.to_string()).into_response(),
+    };
+
+    let memory = store.memory(&id).await;
+    Json(Conversation {
+        live: store.is_live(&id).await,
+        memory: memory.map(MemoryStats::from),
+        id: conversation.id,
+        object: "conversation".to_string(),
+        created: conversation.created_at,
+        model: conversation.model_id,
+        title: conversation.title,
+        messages: messages.into_iter()
+            .map(|m| Message { role: m.role, content: m.content })
+            .collect(),
+    }).into_response()
+}
+
+pub async fn delete(
+    State(state): State<AppState>,
+    Path(id): Path<String>,
+) -> Response {
+    let store = &state.conversations;
+    store.evict(&id).await;
+
+    match store.db.with_connection(|conn| db::chats::delete_session(conn, &id)) {
+        Ok(()) => Json(DeletedConversation {
+            id,
+            object: "conversation.deleted".to_string(),
+            deleted: true,
+        }).into_response(),
+        Err(e) => (StatusCode::INTERNAL_SERVER_ERROR, e.to_string()).into_response(),
+    }
+}
+
+/// Append a user message and answer it, as JSON or as an SSE stream of `TurnEvent`s.
+pub async fn send_message(
+    State(state): State<AppState>,
+    Path(id): Path<String>,
+    Json(payload): Json<MessageRequest>,
+) -> Response {
+    let conversation = match state.conversations.conversation(&id) {
+        Ok(Some(conversation)) => conversation,
+        Ok(None) => return (StatusCode::NOT_FOUND, "Conversation not found").into_response(),
+        Err(e) => return (StatusCode::INTERNAL_SERVER_ERROR, e.to_string()).into_response(),
+    };
+
+    let stream = payload.stream.unwrap_or(false);
+    let mut events = start_turn(state, conversation, payload);
+
+    if stream {
+        let stream = async_stream::stream! {
+            while let Some(event) = events.recv().await {
+                if let Ok(json) = serde_json::to_string(&event) {
+                    yield Ok::<_, Infallible>(Event::default().data(json));
+                }
+            }
+        };
+        return Sse::new(stream).into_response();
+    }
+
+    let mut text = String::new();
+    while let Some(event) = events.recv().await {
+        match event {
+            TurnEvent::Token { content } => text.push_str(&content),
+            TurnEvent::Done { finish_reason, usage } => {
+                return Json(MessageResponse {
+                    conversation_id: id,
+                    message: Message {
+                        role: "assistant".to_string(),
+                        content: text,
+                    },
+                    finish_reason,
+                    usage,
+                }).into_response();
+            }
+            TurnEvent::Error { message } => return (StatusCode::INTERNAL_SERVER_ERROR, message).into_response(),
+        }
+    }
+    (StatusCode::INTERNAL_SERVER_ERROR, "Generation ended without a result").into_response()
+}
+
+/// Conversation over a WebSocket: each text frame is a user message, either
+/// plain text or a `MessageRequest` JSON object; replies are `TurnEvent` frames.
+pub async fn websocket(
+    State(state): State<AppState>,
+    Path(id): Path<String>,
+    upgrade: WebSocketUpgrade,
+) -> Response {
+    let conversation = match state.conversations.conversation(&id) {
+        Ok(Some(conversation)) => conversation,
+        Ok(None) => return (StatusCode::NOT_FOUND, "Conversation not found").into_response(),
+        Err(e) => return (StatusCode::INTERNAL_SERVER_ERROR, e.to_string()).into_response(),
+    };
+
+    upgrade.on_upgrade(move |socket| serve_socket(state, conversation, socket))
+}
+
+async fn serve_socket(state: AppState, conversation: db::ChatSession, mut socket: WebSocket) {
+    while let Some(Ok(frame)) = socket.recv().await {
+        let text = match frame {
+            WsMessage::Text(text) => text,
+            WsMessage::Close(_) => return,
+            _ => continue,
+        };
+        let payload = serde_json::from_str::<MessageRequest>(&text).unwrap_or(MessageRequest {
+            content: text,
+            stream: Some(true),
+            max_tokens: None,
+        });
+
+        let mut events = start_turn(state.clone(), conversation.clone(), payload);
+        while let Some(event) = events.recv().await {
+            let Ok(json) = serde_json::to_string(&event) else {
+                continue;
+            };
+            // A closed socket drops `events`, which stops the turn
+            if socket.send(WsMessage::Text(json)).await.is_err() {
+                return;
+            }
+        }
+    }
+}
+
+/// Run one turn in the background; the turn stops early if the receiver is dropped.
+fn start_turn(state: AppState, conversation: db::ChatSession, payload: MessageRequest) -> mpsc::UnboundedReceiver<TurnEvent> {
+    let (tx, rx) = mpsc::unbounded_channel();
+    tokio::spawn(async move {
+        if let Err(e) = run_turn(&state, &conversation, payload, &tx).await {
+            tx.send(TurnEvent::Error { message: e.to_string() }).ok();
+        }
+    });
+    rx
+}
+
+async fn run_turn(
+    state: &AppState,
+    conversation: &db::ChatSession,
+    payload: MessageRequest,
+    events: &mpsc::UnboundedSender<TurnEvent>,
+) -> anyhow::Result<()> {
+    let store = &state.conversations;
+    let _turn = store.lock_turn(&conversation.id).await;
+    let model_id = conversation.model_id.as_deref()
+        .ok_or_else(|| anyhow::anyhow!("Conversation has no model"))?;
+    let model = state.registry.get_model(model_id)?
+        .ok_or_else(|| anyhow::anyhow!("Model not found: {}", model_id))?;
+
+    let history = store.messages(&conversation.id)?;
+    let system_message = history.iter()
+        .find(|m| m.role == "system")
+        .map(|m| m.content.as_str())
+        .unwrap_or_default();
+    let is_new = history.iter().all(|m| m.role == "system");
+    let max_tokens = payload.max_tokens.unwrap_or(4096);
+
+    store.append(conversation, "user", &payload.content)?;
+
+    let (text, metrics, finish_reason) = match store.checkout(state, &conversation.id, &model, system_message, is_new).await? {
+        Some(session) => {
+            let mut session = session.lock().await;
+            let turn = generate_live(&mut session, &payload.content, max_tokens, events).await;
+
+            // Past the budget the KV cache goes; later turns use the shared engine
+            let over_budget = session.get_context_tokens() > store.config.conversations.max_context_tokens;
+            drop(session);
+            if turn.is_err() || over_budget {
+                store.evict(&conversation.id).await;
+            }
+            turn?
+        }
+        None => {
+            let mut messages: Vec<ChatMessage> = history.into_iter()
+                .map(|m| ChatMessage { role: m.role, content: m.content })
+                .collect();
+            messages.push(ChatMessage {
+                role: "user".to_string(),
+                content: payload.content.clone(),
+            });
+            generate_shared(state, model_id, messages, max_tokens, events).await?
+        }
+    };
+
+    // Stored even when the client left early: the live KV cache holds the partial answer too
+    store.append(conversation, "assistant", &text)?;
+
+    events.send(TurnEvent::Done {
+        finish_reason,
+        usage: Usage::from_metrics(&metrics),
+    }).ok();
+    Ok(())
+}
+
+/// Answer on the conversation's own chat-mode pipeline; only the new message is prefilled.
+async fn generate_live(
+    session: &mut InferenceSession,
+    content: &str,
+    max_tokens: usize,
+    events: &mpsc::UnboundedSender<TurnEvent>,
+) -> anyhow::Result<(String, InferenceMetrics, String)> {
+    let mut task = session.start_generation(content, max_tokens)?;
+
+    while let Some(token) = task.next().await {
+        if events.send(TurnEvent::Token { content: token }).is_err() {
+            task.cancel();
+        }
+    }
+
+    let finish_reason = task.finish_reason().unwrap_or_else(|| "stop".to_string());
+    let (text, metrics) = session.finish_generation(task)?;
+    Ok((text, metrics, finish_reason))
+}
+
+/// Answer on the model's shared batching engine from the full stored history.
+async fn generate_shared(
+    state: &AppState,
+    model_id: &str,
+    messages: Vec<ChatMessage>,
+    max_tokens: usize,
+    events: &mpsc::UnboundedSender<TurnEvent>,
+) -> anyhow::Result<(String, InferenceMetrics, String)> {
+    let session = chat::get_or_load_session(state, model_id).await?;
+
+    let mut stream = {
+        let session = session.read().await;
+        let mut config = GenerationConfig::new()?;
+        config.set_max_new_tokens(max_tokens)?;
+        session.submit_chat(messages, config)?
+    };
+
+    let mut text = String::new();
+    loop {
+        match stream.recv().await {
+            Some(GenerationEvent::Token(token)) => {
+                text.push_str(&token);
+                // Dropping the stream cancels the request
+                if events.send(TurnEvent::Token { content: token }).is_err() {
+                    return Ok((text, InferenceMetrics::default(), "stop".to_string()));
+                }
+            }
+            Some(GenerationEvent::Finished { result, finish_reason }) => {
+                return Ok((result.text, InferenceMetrics::from(&result.metrics), finish_reason));
+            }
+            Some(GenerationEvent::Failed(e)) => return Err(anyhow::anyhow!("Generation failed: {}", e)),
+            None => return Err(anyhow::anyhow!("Generation failed: engine dropped the request")),
+        }
+    }
+}
+
+fn unix_now() -> i64 {
+    std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .unwrap_or_default()
+        .as_secs() as i64
+}
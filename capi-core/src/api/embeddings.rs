@@ -1,15 +1,22 @@
-use axum::{Json, response::IntoResponse};
+use axum::{
+    Json,
+    response::{IntoResponse, Response},
+    extract::State,
+    http::StatusCode,
+};
 use serde::{Deserialize, Serialize};
+use std::sync::Arc;
+
+use super::chat::AppState;
+use crate::EmbeddingSession;
 
 #[derive(Deserialize)]
-#[allow(dead_code)]
 pub struct EmbeddingRequest {
     pub model: Option<String>,
     pub input: EmbeddingInput,
 }
 
 #[derive(Deserialize)]
-#[allow(dead_code)]
 #[serde(untagged)]
 pub enum EmbeddingInput {
     Single(String),
@@ -31,11 +38,78 @@ pub struct EmbeddingData {
 }
 
 pub async fn create(
-    Json(_payload): Json<EmbeddingRequest>,
-) -> impl IntoResponse {
-    Json(EmbeddingResponse {
+    State(state): State<AppState>,
+    Json(payload): Json<EmbeddingRequest>,
+) -> Response {
+    let model_id = match payload.model {
+        Some(id) => id,
+        None => return (StatusCode::BAD_REQUEST, "Model is required").into_response(),
+    };
+
+    let texts = match payload.input {
+        EmbeddingInput::Single(text) => vec![text],
+        EmbeddingInput::Multiple(texts) => texts,
+    };
+
+    match create_response(&state, model_id, texts).await {
+        Ok(response) => Json(response).into_response(),
+        Err(e) => (StatusCode::INTERNAL_SERVER_ERROR, e.to_string()).into_response(),
+    }
+}
+
+async fn create_response(
+    state: &AppState,
+    model_id: String,
+    texts: Vec<String>,
+) -> anyhow::Result<EmbeddingResponse> {
+    let session = get_or_load_embedding_session(state, &model_id).await?;
+
+    // Concurrent requests are merged into shared batches by the engine
+    let embeddings = session.embed(texts).await?;
+
+    let data = embeddings.rows().enumerate().map(|(index, row)| EmbeddingData {
+        object: "embedding".to_string(),
+        embedding: row.to_vec(),
+        index,
+    }).collect();
+
+    Ok(EmbeddingResponse {
         object: "list".to_string(),
-        data: vec![],
-        model: "default".to_string(),
+        data,
+        model: model_id,
     })
 }
+
+/// Return the cached embedding session for a model, loading it on first use.
+/// Concurrent requests for a cold model share one load.
+async fn get_or_load_embedding_session(
+    state: &AppState,
+    model_id: &str,
+) -> anyhow::Result<Arc<EmbeddingSession>> {
+    let registry = Arc::clone(&state.registry);
+    let residency = Arc::clone(&state.residency);
+    let owned_id = model_id.to_string();
+
+    let session = state.embedding_loader.get_or_load(&state.embedding_cache, model_id, move || {
+        let model_id = owned_id;
+        let model = registry.get_model(&model_id)?
+            .ok_or_else(|| anyhow::anyhow!("Model not found: {}", model_id))?;
+        if !model.is_embedding() {
+            return Err(anyhow::anyhow!("{} is not an embedding model", model_id));
+        }
+
+        let config = crate::Config::load()?;
+        let devices = crate::hardware::detect_devices()?;
+        let device = crate::hardware::select_best_device(&devices, &config.device_preference)
+            .unwrap_or_else(|| "CPU".to_string());
+
+        residency.reserve(&model_id, registry.resident_memory_bytes(&config, &model))?;
+        let model_path = std::path::Path::new(&model.path);
+        let session = EmbeddingSession::load(model_path, &device, &config.embeddings)
+            .inspect_err(|_| residency.release(&model_id))?;
+        Ok(Arc::new(session))
+    }).await?;
+
+    state.residency.touch(model_id);
+    Ok(session)
+}
@@ -1,15 +1,24 @@
 pub mod chat;
+mod completions;
+mod conversations;
 mod embeddings;
 mod models;
+mod stats;
 
 use axum::{Router, routing::post};
 pub use chat::AppState;
+pub use conversations::ConversationStore;
 
 pub fn create_router(state: AppState) -> Router {
     Router::new()
         .route("/v1/chat/completions", post(chat::completions))
-        .route("/v1/completions", post(chat::completions_legacy))
+        .route("/v1/completions", post(completions::create))
         .route("/v1/embeddings", post(embeddings::create))
+        .route("/v1/conversations", post(conversations::create))
+        .route("/v1/conversations/:id", axum::routing::get(conversations::get).delete(conversations::delete))
+        .route("/v1/conversations/:id/messages", post(conversations::send_message))
+        .route("/v1/conversations/:id/ws", axum::routing::get(conversations::websocket))
         .route("/v1/models", axum::routing::get(models::list))
+        .route("/v1/stats", axum::routing::get(stats::list))
         .with_state(state)
 }
@@ -1,6 +1,7 @@
 use axum::{Json, response::IntoResponse, extract::State, http::StatusCode};
 use serde::Serialize;
 use crate::api::chat::AppState;
+use std::collections::HashSet;
 
 #[derive(Serialize)]
 pub struct ModelList {
@@ -14,17 +15,50 @@ pub struct Model {
     pub object: String,
     pub created: i64,
     pub owned_by: String,
+    /// Base model of a LoRA adapter
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub parent: Option<String>,
+    /// Extension: "loaded", "loading" or "unloaded"; omitted for adapters
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub status: Option<&'static str>,
 }
 
 pub async fn list(State(state): State<AppState>) -> impl IntoResponse {
+    let mut loaded: HashSet<String> = state.model_cache.read().await.keys().cloned().collect();
+    loaded.extend(state.embedding_cache.read().await.keys().cloned());
+    let mut loading: HashSet<String> = state.model_loader.loading().await.into_iter().map(|l| l.model).collect();
+    loading.extend(state.embedding_loader.loading().await.into_iter().map(|l| l.model));
+
     match state.registry.list_models() {
         Ok(models) => {
-            let model_list = models.into_iter().map(|m| Model {
-                id: m.id,
-                object: "model".to_string(),
-                created: m.created_at,
-                owned_by: "user".to_string(),
-            }).collect();
+            let mut model_list = Vec::new();
+            for m in models {
+                let status = if loaded.contains(&m.id) {
+                    "loaded"
+                } else if loading.contains(&m.id) {
+                    "loading"
+                } else {
+                    "unloaded"
+                };
+                // Adapters are listed after their base so clients can pick them as models
+                let adapters = state.registry.list_adapters(&m.id).unwrap_or_default();
+                model_list.push(Model {
+                    id: m.id,
+                    object: "model".to_string(),
+                    created: m.created_at,
+                    owned_by: "user".to_string(),
+                    parent: None,
+                    status: Some(status),
+                });
+                model_list.extend(adapters.into_iter().map(|a| Model {
+                    id: a.id,
+                    object: "model".to_string(),
+                    created: a.created_at,
+                    owned_by: "user".to_string(),
+                    parent: Some(a.base_model_id),
+                    status: None,
+                }));
+            }
 
             Json(ModelList {
                 object: "list".to_string(),
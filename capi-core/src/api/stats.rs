@@ -0,0 +1,133 @@
+use axum::{Json, response::IntoResponse, extract::State};
+use serde::Serialize;
+use crate::api::chat::AppState;
+use crate::inference::genai::KvCacheUsage;
+use crate::inference::SessionMemory;
+use crate::scheduler::{QueueStats, ResidencyStats};
+
+#[derive(Serialize)]
+pub struct StatsList {
+    pub object: String,
+    pub data: Vec<ModelStats>,
+    /// Server-side request queues, one per model that has received requests
+    pub queues: Vec<QueueStats>,
+    /// Memory charged to loaded models, and models unloaded to stay in budget
+    pub residency: ResidencyStats,
+}
+
+/// KV reuse for one loaded model since it was loaded, and its current KV block usage.
+#[derive(Serialize)]
+pub struct ModelStats {
+    pub model: String,
+    pub requests: u64,
+    pub conversation_hits: u64,
+    pub conversation_hit_rate: f32,
+    pub prompt_tokens: u64,
+    /// Estimated from the prompts sent, not reported by the pipeline: blocks
+    /// the scheduler has evicted since still count as reused
+    pub estimated_cached_tokens: u64,
+    pub estimated_tokens_saved_rate: f32,
+    pub kv_cache: KvCacheStats,
+    pub replicas: Vec<ReplicaStats>,
+    pub memory: MemoryStats,
+}
+
+/// Memory of a session's pipelines. Every compiled pipeline (replica or
+/// live conversation) holds its own copy of the weights.
+#[derive(Serialize)]
+pub struct MemoryStats {
+    /// Size of one copy of the weights
+    pub weight_bytes: u64,
+    /// Compiled pipelines of the session, each holding a copy
+    pub pipelines: usize,
+    /// Weights held across those pipelines
+    pub total_weight_bytes: u64,
+    /// KV budget of this model's batching engines; omitted when the plugin sizes it
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub kv_cache_bytes: Option<u64>,
+}
+
+impl From<SessionMemory> for MemoryStats {
+    fn from(memory: SessionMemory) -> Self {
+        Self {
+            weight_bytes: memory.weight_bytes,
+            pipelines: memory.pipelines,
+            total_weight_bytes: memory.weight_bytes * memory.pipelines as u64,
+            kv_cache_bytes: memory.kv_cache_bytes,
+        }
+    }
+}
+
+/// One continuous-batching engine of a model.
+#[derive(Serialize)]
+pub struct ReplicaStats {
+    pub index: usize,
+    /// Requests submitted to the replica and not yet finished
+    pub in_flight: usize,
+    pub requests: u64,
+    pub kv_cache: KvCacheStats,
+}
+
+#[derive(Serialize)]
+pub struct KvCacheStats {
+    pub usage_pct: f32,
+    pub peak_usage_pct: f32,
+    pub avg_usage_pct: f32,
+    /// Requests in the pipeline, including ones waiting there for blocks
+    pub running_requests: usize,
+    /// Requests held back until KV usage drops below the admission threshold
+    pub queued_requests: usize,
+}
+
+impl From<&KvCacheUsage> for KvCacheStats {
+    fn from(usage: &KvCacheUsage) -> Self {
+        Self {
+            usage_pct: usage.usage_pct,
+            peak_usage_pct: usage.peak_usage_pct,
+            avg_usage_pct: usage.avg_usage_pct,
+            running_requests: usage.running,
+            queued_requests: usage.queued,
+        }
+    }
+}
+
+pub async fn list(State(state): State<AppState>) -> impl IntoResponse {
+    let sessions: Vec<_> = state.model_cache.read().await
+        .iter()
+        .map(|(id, session)| (id.clone(), session.clone()))
+        .collect();
+
+    let mut data = Vec::new();
+    for (model, session) in sessions {
+        // Dedicated pipelines do not share KV across requests
+        let session = session.read().await;
+        let (Some(stats), Some(usage), Some(replicas)) = (session.kv_reuse_stats(), session.kv_cache_usage(), session.replica_stats()) else {
+            continue;
+        };
+        data.push(ModelStats {
+            model,
+            requests: stats.requests,
+            conversation_hits: stats.conversation_hits,
+            conversation_hit_rate: stats.conversation_hit_rate(),
+            prompt_tokens: stats.prompt_tokens,
+            estimated_cached_tokens: stats.estimated_cached_tokens,
+            estimated_tokens_saved_rate: stats.estimated_tokens_saved_rate(),
+            kv_cache: KvCacheStats::from(&usage),
+            replicas: replicas.iter().map(|replica| ReplicaStats {
+                index: replica.index,
+                in_flight: replica.in_flight,
+                requests: replica.requests,
+                kv_cache: KvCacheStats::from(&replica.kv_cache),
+            }).collect(),
+            memory: MemoryStats::from(session.memory_usage()),
+        });
+    }
+    data.sort_by(|a, b| a.model.cmp(&b.model));
+
+    Json(StatsList {
+        object: "list".to_string(),
+        data,
+        queues: state.scheduler.stats(),
+        residency: state.residency.stats(),
+    })
+}
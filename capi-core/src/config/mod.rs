@@ -1,5 +1,6 @@
 use anyhow::Result;
 use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
 use std::fs;
 use std::path::PathBuf;
 
@@ -16,6 +17,240 @@ pub struct Config {
     pub resource_mode: ResourceMode,
     #[serde(default = "default_context_length")]
     pub default_context_length: u64,
+    #[serde(default = "default_compile_cache_max_gb")]
+    pub compile_cache_max_gb: u64,
+    #[serde(default)]
+    pub scheduler: SchedulerSettings,
+    #[serde(default)]
+    pub speculative: SpeculativeSettings,
+    #[serde(default)]
+    pub embeddings: EmbeddingSettings,
+    #[serde(default)]
+    pub conversations: ConversationSettings,
+    #[serde(default)]
+    pub kv_cache: KvCacheSettings,
+    #[serde(default)]
+    pub queue: QueueSettings,
+    #[serde(default)]
+    pub residency: ResidencySettings,
+}
+
+/// Continuous-batching scheduler settings used by the API server.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct SchedulerSettings {
+    /// Reuse computed KV blocks across requests sharing a token prefix
+    #[serde(default = "default_enable_prefix_caching")]
+    pub enable_prefix_caching: bool,
+    /// Chunked prefill: long prompts are split across steps and interleaved
+    /// with ongoing decodes. When off, a prompt is prefilled in one step and
+    /// the token budget must cover the longest prompt.
+    #[serde(default = "default_chunked_prefill")]
+    pub chunked_prefill: bool,
+    /// Tokens processed per scheduler step across all sequences, with chunked
+    /// prefill. Smaller budgets bound inter-token latency under long prompts;
+    /// larger ones prefill faster. Ignored without chunked prefill.
+    #[serde(default = "default_max_batched_tokens")]
+    pub max_batched_tokens: usize,
+    /// Stop admitting new requests while KV cache usage is above this percent.
+    /// They wait in the engine queue instead of forcing running sequences to
+    /// be preempted.
+    #[serde(default = "default_admission_kv_usage_pct")]
+    pub admission_kv_usage_pct: f32,
+    /// Continuous-batching engines per model. Trades memory for throughput:
+    /// each replica compiles its own copy of the weights, so N replicas hold
+    /// N copies. On CPU each gets an equal share of the cores; requests
+    /// sharing a prefix go to the same one unless it is much busier. A KV
+    /// cache budget needs at least 1 GiB per replica, and loads use fewer
+    /// replicas when available RAM cannot hold them all. Defaults to 1.
+    #[serde(default = "default_replicas")]
+    pub replicas: usize,
+    /// Model id -> replica count, overriding `replicas`
+    #[serde(default)]
+    pub model_replicas: HashMap<String, usize>,
+}
+
+impl Default for SchedulerSettings {
+    fn default() -> Self {
+        Self {
+            enable_prefix_caching: default_enable_prefix_caching(),
+            chunked_prefill: default_chunked_prefill(),
+            max_batched_tokens: default_max_batched_tokens(),
+            admission_kv_usage_pct: default_admission_kv_usage_pct(),
+            replicas: default_replicas(),
+            model_replicas: HashMap::new(),
+        }
+    }
+}
+
+/// Speculative decoding: target models paired with smaller draft models, and
+/// defaults for prompt-lookup decoding (enabled per model in the registry).
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct SpeculativeSettings {
+    /// Target model id -> draft model id
+    #[serde(default)]
+    pub draft_models: HashMap<String, String>,
+    /// Tokens drafted per step, by the draft model or by prompt lookup
+    #[serde(default = "default_num_assistant_tokens")]
+    pub num_assistant_tokens: usize,
+    /// Longest prompt n-gram matched by prompt lookup
+    #[serde(default = "default_max_ngram_size")]
+    pub max_ngram_size: usize,
+    /// Device for draft models; defaults to the target model's device
+    #[serde(default)]
+    pub draft_device: Option<String>,
+}
+
+impl Default for SpeculativeSettings {
+    fn default() -> Self {
+        Self {
+            draft_models: HashMap::new(),
+            num_assistant_tokens: default_num_assistant_tokens(),
+            max_ngram_size: default_max_ngram_size(),
+            draft_device: None,
+        }
+    }
+}
+
+/// Embedding models: pooling and micro-batching of concurrent requests.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct EmbeddingSettings {
+    /// Largest number of texts embedded in one inference call
+    #[serde(default = "default_embedding_batch_size")]
+    pub max_batch_size: usize,
+    /// How long to wait for more requests before running a partial batch
+    #[serde(default = "default_embedding_batch_window_ms")]
+    pub batch_window_ms: u64,
+    /// "cls", "mean" or "last_token"; must match how the model was trained
+    #[serde(default = "default_embedding_pooling")]
+    pub pooling: String,
+    #[serde(default = "default_embedding_normalize")]
+    pub normalize: bool,
+    /// Truncate inputs to this many tokens; defaults to the model limit
+    #[serde(default)]
+    pub max_length: Option<usize>,
+}
+
+impl Default for EmbeddingSettings {
+    fn default() -> Self {
+        Self {
+            max_batch_size: default_embedding_batch_size(),
+            batch_window_ms: default_embedding_batch_window_ms(),
+            pooling: default_embedding_pooling(),
+            normalize: default_embedding_normalize(),
+            max_length: None,
+        }
+    }
+}
+
+/// KV cache storage for LLMs; models can override the precision in the registry.
+/// u8 roughly halves KV memory against f16, u4 quarters it.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct KvCacheSettings {
+    /// "auto" (device default), "f16", "u8" or "u4"
+    #[serde(default = "default_kv_cache_precision")]
+    pub precision: String,
+    /// Elements sharing one scale/zero point when quantized; defaults to the head size
+    #[serde(default)]
+    pub group_size: Option<usize>,
+    /// KV cache size in GiB for continuous-batching engines; the cache is
+    /// allocated up front in blocks. Defaults to the OpenVINO plugin's sizing.
+    #[serde(default)]
+    pub budget_gb: Option<usize>,
+    /// Model id -> KV cache budget in GiB, overriding `budget_gb`
+    #[serde(default)]
+    pub model_budgets_gb: HashMap<String, usize>,
+    /// Context a dedicated pipeline is sized for, set per model by the
+    /// registry; None uses `default_context_length`
+    #[serde(skip)]
+    pub context_length: Option<u64>,
+}
+
+impl Default for KvCacheSettings {
+    fn default() -> Self {
+        Self {
+            precision: default_kv_cache_precision(),
+            group_size: None,
+            budget_gb: None,
+            model_budgets_gb: HashMap::new(),
+            context_length: None,
+        }
+    }
+}
+
+/// Per-model request queues in the API server.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct QueueSettings {
+    /// Sequences a model generates at once; later requests wait their turn
+    #[serde(default = "default_queue_max_in_flight")]
+    pub max_in_flight: usize,
+    /// Requests allowed to wait per model; beyond this they get a 429
+    #[serde(default = "default_queue_max_depth")]
+    pub max_queue_depth: usize,
+}
+
+impl Default for QueueSettings {
+    fn default() -> Self {
+        Self {
+            max_in_flight: default_queue_max_in_flight(),
+            max_queue_depth: default_queue_max_depth(),
+        }
+    }
+}
+
+/// Which models the API server keeps loaded.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct ResidencySettings {
+    /// Total estimated memory of loaded models, in GiB. Least recently used
+    /// idle models are unloaded to stay under it; None means no limit.
+    #[serde(default)]
+    pub memory_budget_gb: Option<usize>,
+    /// Seconds a model may sit idle before it is unloaded; 0 keeps it until evicted
+    #[serde(default = "default_keep_alive_secs")]
+    pub keep_alive_secs: u64,
+    /// Model id -> keep-alive override in seconds
+    #[serde(default)]
+    pub model_keep_alive_secs: HashMap<String, u64>,
+    /// Models that are never unloaded once loaded
+    #[serde(default)]
+    pub pinned: Vec<String>,
+}
+
+impl Default for ResidencySettings {
+    fn default() -> Self {
+        Self {
+            memory_budget_gb: None,
+            keep_alive_secs: default_keep_alive_secs(),
+            model_keep_alive_secs: HashMap::new(),
+            pinned: Vec::new(),
+        }
+    }
+}
+
+/// Server-held conversations (/v1/conversations). Each live conversation
+/// pins a chat-mode pipeline with its own weights and KV cache, charged to the
+/// residency budget at `max_context_tokens` of KV.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct ConversationSettings {
+    /// Upper bound on conversations kept live at once; memory may allow fewer.
+    /// Past it the least recently used idle one is evicted
+    #[serde(default = "default_max_live_conversations")]
+    pub max_live: usize,
+    /// Evict a live conversation after this long without a message
+    #[serde(default = "default_conversation_idle_timeout_secs")]
+    pub idle_timeout_secs: u64,
+    /// Evict a live conversation once its KV cache holds this many tokens
+    #[serde(default = "default_conversation_max_context_tokens")]
+    pub max_context_tokens: usize,
+}
+
+impl Default for ConversationSettings {
+    fn default() -> Self {
+        Self {
+            max_live: default_max_live_conversations(),
+            idle_timeout_secs: default_conversation_idle_timeout_secs(),
+            max_context_tokens: default_conversation_max_context_tokens(),
+        }
+    }
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -42,6 +277,82 @@ fn default_context_length() -> u64 {
     4096
 }
 
+fn default_compile_cache_max_gb() -> u64 {
+    8
+}
+
+fn default_enable_prefix_caching() -> bool {
+    true
+}
+
+fn default_chunked_prefill() -> bool {
+    true
+}
+
+fn default_max_batched_tokens() -> usize {
+    256
+}
+
+fn default_admission_kv_usage_pct() -> f32 {
+    90.0
+}
+
+fn default_num_assistant_tokens() -> usize {
+    5
+}
+
+fn default_max_ngram_size() -> usize {
+    3
+}
+
+fn default_embedding_batch_size() -> usize {
+    32
+}
+
+fn default_embedding_batch_window_ms() -> u64 {
+    2
+}
+
+fn default_embedding_pooling() -> String {
+    "cls".to_string()
+}
+
+fn default_embedding_normalize() -> bool {
+    true
+}
+
+fn default_kv_cache_precision() -> String {
+    "auto".to_string()
+}
+
+fn default_queue_max_in_flight() -> usize {
+    32
+}
+
+fn default_queue_max_depth() -> usize {
+    64
+}
+
+fn default_replicas() -> usize {
+    1
+}
+
+fn default_keep_alive_secs() -> u64 {
+    600
+}
+
+fn default_max_live_conversations() -> usize {
+    2
+}
+
+fn default_conversation_idle_timeout_secs() -> u64 {
+    600
+}
+
+fn default_conversation_max_context_tokens() -> usize {
+    16384
+}
+
 impl Default for Config {
     fn default() -> Self {
         let data_dir = Self::default_data_dir();
@@ -55,6 +366,14 @@ impl Default for Config {
             keep_server_running: false,
             resource_mode: ResourceMode::Strict,
             default_context_length: 4096,
+            compile_cache_max_gb: default_compile_cache_max_gb(),
+            scheduler: SchedulerSettings::default(),
+            speculative: SpeculativeSettings::default(),
+            embeddings: EmbeddingSettings::default(),
+            conversations: ConversationSettings::default(),
+            kv_cache: KvCacheSettings::default(),
+            queue: QueueSettings::default(),
+            residency: ResidencySettings::default(),
         }
     }
 }
@@ -126,6 +445,10 @@ impl Config {
         self.data_dir.join("capi.db")
     }
 
+    pub fn compile_cache_dir(&self) -> PathBuf {
+        self.data_dir.join("compiled_cache")
+    }
+
     pub fn server_url(&self) -> String {
         format!("http://{}:{}", self.server_host, self.server_port)
     }
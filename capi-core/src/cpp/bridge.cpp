@@ -3,21 +3,174 @@
 
 namespace genai_bridge {
 
+// Helper to build an OpenVINO property map; plugins parse string values
+ov::AnyMap to_any_map(rust::Slice<const PipelineProperty> properties) {
+    ov::AnyMap map;
+    for (const auto& property : properties) {
+        map[std::string(property.key)] = std::string(property.value);
+    }
+    return map;
+}
+
+// Attach a draft model or enable prompt lookup; both properties are understood
+// by LLMPipeline and ContinuousBatchingPipeline. A draft model takes precedence.
+ov::AnyMap with_speculative(ov::AnyMap properties, const SpeculativeConfigData& speculative) {
+    if (!speculative.draft_model_path.empty()) {
+        properties.insert(ov::genai::draft_model(
+            std::string(speculative.draft_model_path),
+            std::string(speculative.draft_device)
+        ));
+    } else if (speculative.prompt_lookup) {
+        properties.insert(ov::genai::prompt_lookup(true));
+    }
+    return properties;
+}
+
+// Read each LoRA adapter once; generation configs refer to them by name
+std::map<std::string, ov::genai::Adapter> load_adapters(rust::Slice<const LoraAdapterData> adapters) {
+    std::map<std::string, ov::genai::Adapter> loaded;
+    for (const auto& adapter : adapters) {
+        loaded.emplace(std::string(adapter.name), ov::genai::Adapter(std::string(adapter.path)));
+    }
+    return loaded;
+}
+
+// Register the adapters at compile time so they can be switched per request
+// without recompiling; the pipeline keeps a single copy of the base weights
+ov::AnyMap with_adapters(ov::AnyMap properties, const std::map<std::string, ov::genai::Adapter>& adapters) {
+    if (adapters.empty()) {
+        return properties;
+    }
+    ov::genai::AdapterConfig config;
+    for (const auto& [name, adapter] : adapters) {
+        config.add(adapter);
+    }
+    properties.insert(ov::genai::adapters(config));
+    return properties;
+}
+
+// End-of-turn markers of common chat templates. Generation configs often
+// name only the base EOS, so an instruct model keeps going past the end of
+// its turn unless its template's marker is a stop token too.
+const char* const END_OF_TURN_TOKENS[] = {
+    "<|im_end|>",
+    "<|eot_id|>",
+    "<|end|>",
+    "<end_of_turn>",
+    "<|endoftext|>",
+    "<|end_of_text|>",
+    "</s>",
+};
+
+RequestDefaults request_defaults(
+    const SpeculativeConfigData& speculative,
+    const ov::genai::Tokenizer& tokenizer,
+    const ov::genai::GenerationConfig& model_config
+) {
+    RequestDefaults defaults;
+    if (!speculative.draft_model_path.empty()) {
+        defaults.num_assistant_tokens = speculative.num_assistant_tokens;
+    } else if (speculative.prompt_lookup) {
+        defaults.num_assistant_tokens = speculative.num_assistant_tokens;
+        defaults.max_ngram_size = speculative.max_ngram_size;
+        defaults.prompt_lookup = true;
+    }
+
+    // generation_config.json (or GGUF metadata), then the tokenizer's own EOS
+    defaults.eos_token_id = model_config.eos_token_id >= 0 ? model_config.eos_token_id : tokenizer.get_eos_token_id();
+    defaults.stop_token_ids = model_config.stop_token_ids;
+    if (defaults.eos_token_id >= 0) {
+        defaults.stop_token_ids.insert(defaults.eos_token_id);
+    }
+
+    // Only markers the chat template actually closes turns with; a token that
+    // merely exists in the vocabulary may be ordinary output for this model
+    std::string chat_template = tokenizer.get_chat_template();
+    if (chat_template.empty()) {
+        return defaults;
+    }
+    auto vocab = tokenizer.get_vocab();
+    for (const char* marker : END_OF_TURN_TOKENS) {
+        if (chat_template.find(marker) == std::string::npos) {
+            continue;
+        }
+        auto it = vocab.find(marker);
+        if (it != vocab.end()) {
+            defaults.stop_token_ids.insert(it->second);
+        }
+    }
+    return defaults;
+}
+
+// Speculative pipelines reject requests without a draft length (and, for
+// prompt lookup, an n-gram size); fill in the pipeline defaults unless the
+// request chose its own. Model stop tokens are always added. Pipelines with
+// adapters always get an explicit selection, since an unset one means all
+// registered adapters at once.
+ov::genai::GenerationConfig with_request_defaults(
+    const GenerationConfigWrapper& config,
+    const RequestDefaults& defaults
+) {
+    ov::genai::GenerationConfig effective = config.config;
+    if (defaults.num_assistant_tokens > 0 && effective.num_assistant_tokens == 0 && effective.assistant_confidence_threshold == 0.0f) {
+        effective.num_assistant_tokens = defaults.num_assistant_tokens;
+    }
+    if (defaults.max_ngram_size > 0 && effective.max_ngram_size == 0) {
+        effective.max_ngram_size = defaults.max_ngram_size;
+    }
+    if (effective.eos_token_id < 0) {
+        effective.eos_token_id = defaults.eos_token_id;
+    }
+    effective.stop_token_ids.insert(defaults.stop_token_ids.begin(), defaults.stop_token_ids.end());
+
+    if (!config.adapter.empty() && defaults.adapters.empty()) {
+        throw std::runtime_error("Model was loaded without adapters, cannot apply " + config.adapter);
+    }
+    if (!defaults.adapters.empty()) {
+        ov::genai::AdapterConfig selected;
+        if (!config.adapter.empty()) {
+            auto it = defaults.adapters.find(config.adapter);
+            if (it == defaults.adapters.end()) {
+                throw std::runtime_error("Adapter not loaded: " + config.adapter);
+            }
+            selected.add(it->second, config.adapter_alpha);
+        }
+        effective.adapters = selected;
+    }
+    return effective;
+}
+
 // Factory functions
 std::unique_ptr<LLMPipelineWrapper> create_pipeline(
     rust::Str model_path,
-    rust::Str device
+    rust::Str device,
+    rust::Slice<const PipelineProperty> properties,
+    const SpeculativeConfigData& speculative,
+    rust::Slice<const LoraAdapterData> adapters
 ) {
-    return std::make_unique<LLMPipelineWrapper>(
+    auto loaded = load_adapters(adapters);
+    auto wrapper = std::make_unique<LLMPipelineWrapper>(
         std::string(model_path),
-        std::string(device)
+        std::string(device),
+        with_adapters(with_speculative(to_any_map(properties), speculative), loaded)
+    );
+    wrapper->request_defaults = request_defaults(
+        speculative,
+        wrapper->tokenizer.tokenizer,
+        wrapper->pipeline->get_generation_config()
     );
+    wrapper->request_defaults.adapters = std::move(loaded);
+    return wrapper;
 }
 
 std::unique_ptr<GenerationConfigWrapper> create_generation_config() {
     return std::make_unique<GenerationConfigWrapper>();
 }
 
+rust::String openvino_version() {
+    return rust::String(ov::get_openvino_version().buildNumber);
+}
+
 // Helper to extract metrics from OpenVINO PerfMetrics
 PerfMetricsData extract_metrics(const ov::genai::PerfMetrics& metrics) {
     PerfMetricsData data;
@@ -30,6 +183,53 @@ PerfMetricsData extract_metrics(const ov::genai::PerfMetrics& metrics) {
     data.throughput_std = metrics.throughput.std;
     data.generate_duration_mean = metrics.generate_duration.mean;
     data.generate_duration_std = metrics.generate_duration.std;
+    data.tpot_mean = metrics.tpot.mean;
+    data.tpot_std = metrics.tpot.std;
+    data.ipot_mean = metrics.ipot.mean;
+    data.ipot_std = metrics.ipot.std;
+    data.tokenization_duration_mean = metrics.tokenization_duration.mean;
+    data.tokenization_duration_std = metrics.tokenization_duration.std;
+    data.detokenization_duration_mean = metrics.detokenization_duration.mean;
+    data.detokenization_duration_std = metrics.detokenization_duration.std;
+    data.inference_duration_mean = metrics.inference_duration.mean;
+    data.inference_duration_std = metrics.inference_duration.std;
+
+    // The first step duration is the time to first token, not an inter-token gap
+    const auto& raw = metrics.raw_metrics;
+    if (raw.m_durations.size() > 1) {
+        data.itl_ms.reserve(raw.m_durations.size() - 1);
+        for (size_t i = 1; i < raw.m_durations.size(); ++i) {
+            data.itl_ms.push_back(raw.m_durations[i].count() / 1000.0f);
+        }
+    }
+    if (!raw.m_new_token_times.empty()) {
+        const auto first = raw.m_new_token_times.front();
+        data.token_times_ms.reserve(raw.m_new_token_times.size());
+        for (const auto& time : raw.m_new_token_times) {
+            data.token_times_ms.push_back(std::chrono::duration<float, std::milli>(time - first).count());
+        }
+    }
+    data.estimated_prefix_blocks_hit = 0;
+    data.estimated_prefix_blocks_missed = 0;
+    data.cached_tokens = 0;
+    data.num_draft_tokens = 0;
+    data.num_accepted_tokens = 0;
+    data.queue_time_ms = 0;
+    data.prefill_time_ms = 0;
+    return data;
+}
+
+// Same as above, plus draft acceptance when the pipeline ran speculative decoding
+PerfMetricsData extract_metrics(
+    const ov::genai::PerfMetrics& metrics,
+    const std::shared_ptr<ov::genai::ExtendedPerfMetrics>& extended
+) {
+    PerfMetricsData data = extract_metrics(metrics);
+    auto sd = std::dynamic_pointer_cast<ov::genai::SDPerModelsPerfMetrics>(extended);
+    if (sd) {
+        data.num_draft_tokens = sd->draft_model_metrics.get_num_generated_tokens();
+        data.num_accepted_tokens = sd->get_num_accepted_tokens();
+    }
     return data;
 }
 
@@ -39,9 +239,10 @@ rust::String pipeline_generate(
     rust::Str prompt,
     const GenerationConfigWrapper& config
 ) {
+    std::lock_guard<std::mutex> lock(*pipeline.busy);
     auto result = pipeline.pipeline->generate(
         std::string(prompt),
-        config.config
+        with_request_defaults(config, pipeline.request_defaults)
     );
     
     if (result.texts.empty()) {
@@ -55,17 +256,207 @@ GenerationResultData pipeline_generate_with_metrics(
     rust::Str prompt,
     const GenerationConfigWrapper& config
 ) {
+    std::lock_guard<std::mutex> lock(*pipeline.busy);
     auto result = pipeline.pipeline->generate(
         std::string(prompt),
-        config.config
+        with_request_defaults(config, pipeline.request_defaults)
     );
     
     GenerationResultData data;
     data.text = result.texts.empty() ? rust::String("") : rust::String(result.texts[0]);
-    data.metrics = extract_metrics(result.perf_metrics);
+    data.metrics = extract_metrics(result.perf_metrics, result.extended_perf_metrics);
     return data;
 }
 
+BatchGenerationResultData pipeline_generate_batch(
+    const LLMPipelineWrapper& pipeline,
+    rust::Slice<const rust::Str> prompts,
+    const GenerationConfigWrapper& config
+) {
+    BatchGenerationResultData data;
+    data.metrics = PerfMetricsData{};
+    if (prompts.empty()) {
+        return data;
+    }
+
+    std::vector<std::string> inputs;
+    inputs.reserve(prompts.size());
+    for (const auto& prompt : prompts) {
+        inputs.emplace_back(prompt);
+    }
+
+    // Tokenize once and run all prompts as a single padded batch
+    const auto& tokenizer = pipeline.tokenizer.tokenizer;
+    auto encoded = tokenizer.encode(inputs);
+    auto result = [&] {
+        std::lock_guard<std::mutex> lock(*pipeline.busy);
+        return pipeline.pipeline->generate(encoded, with_request_defaults(config, pipeline.request_defaults));
+    }();
+    auto texts = tokenizer.decode(result.tokens);
+
+    const auto& mask = encoded.attention_mask;
+    size_t seq_len = mask.get_shape()[1];
+    const int64_t* mask_data = mask.data<const int64_t>();
+
+    data.texts.reserve(texts.size());
+    data.sequences.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        // With num_return_sequences > 1 outputs are grouped per prompt
+        size_t row = i * prompts.size() / texts.size();
+        size_t input_tokens = 0;
+        for (size_t j = 0; j < seq_len; ++j) {
+            input_tokens += mask_data[row * seq_len + j] != 0;
+        }
+
+        SequenceMetricsData seq;
+        seq.num_input_tokens = input_tokens;
+        seq.num_generated_tokens = result.tokens[i].size();
+        seq.score = i < result.scores.size() ? result.scores[i] : 0.0f;
+
+        data.texts.push_back(rust::String::lossy(texts[i]));
+        data.sequences.push_back(seq);
+    }
+    data.metrics = extract_metrics(result.perf_metrics, result.extended_perf_metrics);
+    return data;
+}
+
+void IncrementalDecoder::decode(ov::genai::Tokenizer& tokenizer, const std::vector<int64_t>& tokens, std::string& out, bool final) {
+    if (tokens.size() <= read_offset) {
+        return;
+    }
+
+    window.assign(tokens.begin() + prefix_offset, tokens.begin() + read_offset);
+    std::string prefix = tokenizer.decode(window);
+    window.insert(window.end(), tokens.begin() + read_offset, tokens.end());
+    std::string text = tokenizer.decode(window);
+
+    // Hold back an incomplete multi-byte sequence (decoded as U+FFFD)
+    bool incomplete = text.size() >= 3 && text.compare(text.size() - 3, 3, "\xEF\xBF\xBD") == 0;
+    if (text.size() <= prefix.size() || (incomplete && !final)) {
+        return;
+    }
+
+    out.append(text, prefix.size(), std::string::npos);
+    prefix_offset = read_offset;
+    read_offset = tokens.size();
+}
+
+// Streamer that detokenizes incrementally into a reused buffer and hands the
+// sink only the new bytes, instead of a std::string per token
+class DecodingStreamer : public ov::genai::StreamerBase {
+public:
+    explicit DecodingStreamer(ov::genai::Tokenizer tokenizer)
+        : m_tokenizer(std::move(tokenizer)) {
+        m_tokens.reserve(256);
+        m_text.reserve(64);
+    }
+
+    ov::genai::StreamingStatus write(int64_t token) override {
+        m_tokens.push_back(token);
+        ++m_generated;
+        m_last_token = token;
+        return flush(false);
+    }
+
+    ov::genai::StreamingStatus write(const std::vector<int64_t>& tokens) override {
+        if (tokens.empty()) {
+            return flush(false);
+        }
+        m_tokens.insert(m_tokens.end(), tokens.begin(), tokens.end());
+        m_generated += tokens.size();
+        m_last_token = tokens.back();
+        return flush(false);
+    }
+
+    // Why generation ended: "length" if it used up max_new_tokens without
+    // ending on a stop token, else "stop"
+    std::string finish_reason(const ov::genai::GenerationConfig& config) const {
+        bool stop_token = m_last_token == config.eos_token_id || config.stop_token_ids.count(m_last_token) > 0;
+        return m_generated >= config.max_new_tokens && !stop_token ? "length" : "stop";
+    }
+
+    void end() override {
+        flush(true);
+        m_tokens.clear();
+        m_decoder.reset();
+    }
+
+protected:
+    // Receives newly decoded bytes; returns how generation should proceed
+    virtual ov::genai::StreamingStatus emit(const char* data, size_t len) = 0;
+
+    // Checked on every write, even when no new text is ready
+    virtual ov::genai::StreamingStatus status() const {
+        return ov::genai::StreamingStatus::RUNNING;
+    }
+
+private:
+    ov::genai::StreamingStatus flush(bool final) {
+        if (!final && status() != ov::genai::StreamingStatus::RUNNING) {
+            return status();
+        }
+
+        m_text.clear();
+        m_decoder.decode(m_tokenizer, m_tokens, m_text, final);
+        if (m_text.empty()) {
+            return ov::genai::StreamingStatus::RUNNING;
+        }
+        return emit(m_text.data(), m_text.size());
+    }
+
+    ov::genai::Tokenizer m_tokenizer;
+    std::vector<int64_t> m_tokens;
+    size_t m_generated = 0;
+    int64_t m_last_token = -1;
+    IncrementalDecoder m_decoder;
+    // Holds each chunk until the sink has consumed it; reused across tokens
+    std::string m_text;
+};
+
+// Passes a borrowed slice of each chunk to the Rust callback
+class RustStreamer : public DecodingStreamer {
+public:
+    RustStreamer(ov::genai::Tokenizer tokenizer, StreamerCallback& callback)
+        : DecodingStreamer(std::move(tokenizer)), m_callback(callback) {}
+
+protected:
+    ov::genai::StreamingStatus emit(const char* data, size_t len) override {
+        rust::Slice<const uint8_t> slice(reinterpret_cast<const uint8_t*>(data), len);
+        return m_callback.on_token(slice)
+            ? ov::genai::StreamingStatus::RUNNING
+            : ov::genai::StreamingStatus::STOP;
+    }
+
+private:
+    StreamerCallback& m_callback;
+};
+
+// Buffers chunks for poll_tokens and wakes the Rust side
+class AsyncStreamer : public DecodingStreamer {
+public:
+    AsyncStreamer(ov::genai::Tokenizer tokenizer, std::shared_ptr<GenerationState> state)
+        : DecodingStreamer(std::move(tokenizer)), m_state(std::move(state)) {}
+
+protected:
+    ov::genai::StreamingStatus emit(const char* data, size_t len) override {
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->pending.append(data, len);
+        }
+        m_state->notifier->notify();
+        return status();
+    }
+
+    ov::genai::StreamingStatus status() const override {
+        return m_state->cancelled.load()
+            ? ov::genai::StreamingStatus::CANCEL
+            : ov::genai::StreamingStatus::RUNNING;
+    }
+
+private:
+    std::shared_ptr<GenerationState> m_state;
+};
+
 // Streaming generation with Rust callback
 GenerationResultData pipeline_generate_stream(
     const LLMPipelineWrapper& pipeline,
@@ -73,35 +464,492 @@ GenerationResultData pipeline_generate_stream(
     const GenerationConfigWrapper& config,
     StreamerCallback& callback
 ) {
-    // Create C++ lambda that calls Rust object method
-    auto streamer = [&callback](std::string token) -> ov::genai::StreamingStatus {
-        rust::Slice<const uint8_t> slice(reinterpret_cast<const uint8_t*>(token.data()), token.size());
-        bool should_continue = callback.on_token(slice);
-        return should_continue 
-            ? ov::genai::StreamingStatus::RUNNING 
-            : ov::genai::StreamingStatus::STOP;
-    };
+    auto streamer = std::make_shared<RustStreamer>(pipeline.tokenizer.tokenizer, callback);
     
+    std::lock_guard<std::mutex> lock(*pipeline.busy);
     auto result = pipeline.pipeline->generate(
         std::string(prompt),
-        config.config,
+        with_request_defaults(config, pipeline.request_defaults),
         streamer
     );
     
     GenerationResultData data;
     data.text = result.texts.empty() ? rust::String("") : rust::String(result.texts[0]);
-    data.metrics = extract_metrics(result.perf_metrics);
+    data.metrics = extract_metrics(result.perf_metrics, result.extended_perf_metrics);
     return data;
 }
 
-void pipeline_start_chat(LLMPipelineWrapper& pipeline) {
-    pipeline.pipeline->start_chat();
+// Background generation
+AsyncGenerationWrapper::AsyncGenerationWrapper(rust::Box<GenerationNotifier> notifier)
+    : state(std::make_shared<GenerationState>(std::move(notifier))) {}
+
+AsyncGenerationWrapper::~AsyncGenerationWrapper() {
+    // Dropped from async code, so don't wait: the worker owns what it uses
+    // and releases the pipeline at the next token boundary
+    state->cancelled.store(true);
+    if (worker.joinable()) {
+        worker.detach();
+    }
+}
+
+// Input is a prompt string or a ChatHistory; both go to LLMPipeline::generate
+template <typename Input>
+std::unique_ptr<AsyncGenerationWrapper> spawn_generation(
+    const LLMPipelineWrapper& pipeline,
+    Input input,
+    const GenerationConfigWrapper& config,
+    rust::Box<GenerationNotifier> notifier
+) {
+    auto generation = std::make_unique<AsyncGenerationWrapper>(std::move(notifier));
+    auto streamer = std::make_shared<AsyncStreamer>(pipeline.tokenizer.tokenizer, generation->state);
+    auto effective = with_request_defaults(config, pipeline.request_defaults);
+
+    generation->worker = std::thread([
+        llm = pipeline.pipeline,
+        busy = pipeline.busy,
+        state = generation->state,
+        streamer,
+        effective,
+        input = std::move(input)
+    ]() {
+        try {
+            std::lock_guard<std::mutex> pipeline_lock(*busy);
+            auto result = llm->generate(input, effective, streamer);
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->result = std::move(result);
+            state->finish_reason = streamer->finish_reason(effective);
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->error = e.what();
+        }
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->finished = true;
+        }
+        state->notifier->notify();
+    });
+    return generation;
+}
+
+std::unique_ptr<AsyncGenerationWrapper> start_generation(
+    const LLMPipelineWrapper& pipeline,
+    rust::Str prompt,
+    const GenerationConfigWrapper& config,
+    rust::Box<GenerationNotifier> notifier
+) {
+    return spawn_generation(pipeline, std::string(prompt), config, std::move(notifier));
+}
+
+TokenPoll poll_tokens(AsyncGenerationWrapper& generation) {
+    auto& state = *generation.state;
+    std::lock_guard<std::mutex> lock(state.mutex);
+    TokenPoll poll;
+    poll.text = rust::String::lossy(state.pending);
+    poll.finished = state.finished;
+    state.pending.clear();
+    return poll;
+}
+
+void cancel_generation(AsyncGenerationWrapper& generation) {
+    generation.state->cancelled.store(true);
+}
+
+GenerationResultData join_generation(AsyncGenerationWrapper& generation) {
+    if (generation.worker.joinable()) {
+        generation.worker.join();
+    }
+
+    auto& state = *generation.state;
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.error.empty()) {
+        throw std::runtime_error(state.error);
+    }
+
+    const auto& result = state.result;
+    GenerationResultData data;
+    data.text = result.texts.empty() ? rust::String("") : rust::String::lossy(result.texts[0]);
+    data.metrics = extract_metrics(result.perf_metrics, result.extended_perf_metrics);
+    return data;
+}
+
+rust::String generation_finish_reason(const AsyncGenerationWrapper& generation) {
+    std::lock_guard<std::mutex> lock(generation.state->mutex);
+    return rust::String(generation.state->finish_reason);
+}
+
+void pipeline_start_chat(LLMPipelineWrapper& pipeline, rust::Str system_message) {
+    std::lock_guard<std::mutex> lock(*pipeline.busy);
+    pipeline.pipeline->start_chat(std::string(system_message));
 }
 
 void pipeline_finish_chat(LLMPipelineWrapper& pipeline) {
+    std::lock_guard<std::mutex> lock(*pipeline.busy);
     pipeline.pipeline->finish_chat();
 }
 
+// Continuous batching methods
+std::pair<size_t, size_t> PrefixCacheIndex::lookup_and_insert(const int64_t* ids, size_t len) {
+    size_t hits = 0;
+    size_t misses = 0;
+    bool matching = true;
+    uint64_t hash = 1469598103934665603ULL;
+
+    for (size_t i = 0; i + block_size <= len; i += block_size) {
+        // Hash of the whole prefix up to this block, like the scheduler's block keys
+        for (size_t j = i; j < i + block_size; ++j) {
+            hash = (hash ^ static_cast<uint64_t>(ids[j])) * 1099511628211ULL;
+        }
+        // A block can only be reused if every block before it was
+        bool cached = blocks.count(hash) > 0 || previous.count(hash) > 0;
+        if (matching && cached) {
+            ++hits;
+        } else {
+            matching = false;
+            ++misses;
+        }
+        if (blocks.size() >= max_blocks) {
+            previous.swap(blocks);
+            blocks.clear();
+        }
+        blocks.insert(hash);
+    }
+    return {hits, misses};
+}
+
+std::unique_ptr<ContinuousBatchingWrapper> create_cb_pipeline(
+    rust::Str model_path,
+    rust::Str device,
+    const SchedulerConfigData& scheduler,
+    rust::Slice<const PipelineProperty> properties,
+    const SpeculativeConfigData& speculative,
+    rust::Slice<const LoraAdapterData> adapters
+) {
+    std::string device_str(device);
+
+    ov::genai::SchedulerConfig scheduler_config;
+    scheduler_config.enable_prefix_caching = scheduler.enable_prefix_caching;
+    // With split-fuse a long prompt takes at most the remaining token budget per
+    // step, so decodes of other sequences keep advancing while it prefills
+    scheduler_config.dynamic_split_fuse = scheduler.dynamic_split_fuse;
+    if (scheduler.max_num_batched_tokens > 0) {
+        scheduler_config.max_num_batched_tokens = scheduler.max_num_batched_tokens;
+    }
+    // A fixed cache is split into blocks up front; when they run out the
+    // scheduler preempts the newest running sequence and recomputes it later
+    if (scheduler.cache_size_gb > 0) {
+        scheduler_config.cache_size = scheduler.cache_size_gb;
+    }
+
+    // Default KV block size of the OpenVINO plugins; the pipeline does not
+    // report the one it uses, so block counts are estimates
+    size_t block_size = device_str.find("GPU") != std::string::npos ? 16 : 32;
+
+    auto loaded = load_adapters(adapters);
+    auto wrapper = std::make_unique<ContinuousBatchingWrapper>(
+        std::string(model_path),
+        device_str,
+        scheduler_config,
+        with_adapters(with_speculative(to_any_map(properties), speculative), loaded),
+        block_size
+    );
+    wrapper->request_defaults = request_defaults(
+        speculative,
+        wrapper->tokenizer,
+        wrapper->pipeline->get_config()
+    );
+    wrapper->request_defaults.adapters = std::move(loaded);
+    return wrapper;
+}
+
+std::unique_ptr<GenerationHandleWrapper> add_tokenized_request(
+    ContinuousBatchingWrapper& pipeline,
+    uint64_t request_id,
+    const ov::Tensor& input_ids,
+    const GenerationConfigWrapper& config
+) {
+    size_t num_input_tokens = input_ids.get_size();
+
+    auto effective = with_request_defaults(config, pipeline.request_defaults);
+    auto handle = pipeline.pipeline->add_request(request_id, input_ids, effective);
+    auto wrapper = std::make_unique<GenerationHandleWrapper>(std::move(handle), pipeline.tokenizer, num_input_tokens);
+    // A prompt-lookup step drafts nothing when no n-gram matches, and the
+    // handle does not say which steps matched, so acceptance is only
+    // estimated for a draft model
+    const auto& defaults = pipeline.request_defaults;
+    wrapper->num_assistant_tokens = defaults.num_assistant_tokens > 0 && !defaults.prompt_lookup ? effective.num_assistant_tokens : 0;
+
+    if (pipeline.prefix_caching) {
+        auto counts = pipeline.prefix_index.lookup_and_insert(input_ids.data<const int64_t>(), num_input_tokens);
+        wrapper->estimated_prefix_blocks_hit = counts.first;
+        wrapper->estimated_prefix_blocks_missed = counts.second;
+        wrapper->cached_tokens = counts.first * pipeline.prefix_index.block_size;
+    }
+    return wrapper;
+}
+
+std::unique_ptr<GenerationHandleWrapper> cb_add_request(
+    ContinuousBatchingWrapper& pipeline,
+    uint64_t request_id,
+    rust::Str prompt,
+    const GenerationConfigWrapper& config
+) {
+    // Tokenize here so the prompt length is known without a second pass on the Rust side
+    auto inputs = pipeline.tokenizer.encode(std::string(prompt));
+    return add_tokenized_request(pipeline, request_id, inputs.input_ids, config);
+}
+
+// Chat templates
+ov::genai::ChatHistory to_chat_history(rust::Slice<const ChatMessageData> messages) {
+    ov::genai::ChatHistory history;
+    for (const auto& message : messages) {
+        history.push_back({{"role", std::string(message.role)}, {"content", std::string(message.content)}});
+    }
+    return history;
+}
+
+// Models without a chat template get the plain "Role: content" transcript
+// the server used before templates were applied
+std::string render_chat(ov::genai::Tokenizer& tokenizer, rust::Slice<const ChatMessageData> messages, bool add_generation_prompt) {
+    if (!tokenizer.get_chat_template().empty()) {
+        return tokenizer.apply_chat_template(to_chat_history(messages), add_generation_prompt);
+    }
+
+    std::string text;
+    for (const auto& message : messages) {
+        if (!text.empty()) {
+            text += "\n";
+        }
+        std::string role(message.role);
+        text += role == "user" ? "User: " : role == "system" ? "System: " : "Assistant: ";
+        text += std::string(message.content);
+    }
+    if (add_generation_prompt) {
+        text += "\nAssistant:";
+    }
+    return text;
+}
+
+// Outside chat mode the pipeline resets its KV cache, so the whole history is
+// prefilled; in chat mode it becomes the chat history later turns extend
+std::unique_ptr<AsyncGenerationWrapper> start_chat_generation(
+    const LLMPipelineWrapper& pipeline,
+    rust::Slice<const ChatMessageData> messages,
+    const GenerationConfigWrapper& config,
+    rust::Box<GenerationNotifier> notifier
+) {
+    auto& tokenizer = pipeline.tokenizer.tokenizer;
+    if (tokenizer.get_chat_template().empty()) {
+        return spawn_generation(pipeline, render_chat(tokenizer, messages, true), config, std::move(notifier));
+    }
+    return spawn_generation(pipeline, to_chat_history(messages), config, std::move(notifier));
+}
+
+// FNV-1a over the messages; entry k keys the first k messages
+std::vector<uint64_t> message_prefix_hashes(rust::Slice<const ChatMessageData> messages) {
+    std::vector<uint64_t> hashes;
+    hashes.reserve(messages.size() + 1);
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](const char* data, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 0x100000001b3ULL;
+        }
+    };
+
+    hashes.push_back(hash);
+    for (const auto& message : messages) {
+        mix(message.role.data(), message.role.size());
+        mix("\x1f", 1);
+        mix(message.content.data(), message.content.size());
+        mix("\x1e", 1);
+        hashes.push_back(hash);
+    }
+    return hashes;
+}
+
+// Templates already contain BOS and role markers, so no special tokens are added
+std::vector<int64_t> encode_template_text(ov::genai::Tokenizer& tokenizer, const std::string& text) {
+    if (text.empty()) {
+        return {};
+    }
+    auto inputs = tokenizer.encode(text, ov::genai::add_special_tokens(false));
+    const int64_t* data = inputs.input_ids.data<const int64_t>();
+    return std::vector<int64_t>(data, data + inputs.input_ids.get_size());
+}
+
+// Spliced prompts verified before splicing is trusted, and the sampling
+// interval after that
+constexpr size_t VERIFIED_SPLICES = 16;
+constexpr size_t VERIFY_EVERY = 16;
+
+// Splits fall on message boundaries. Most templates delimit those with special
+// tokens, so tokenizing in pieces matches tokenizing the whole prompt; that
+// is verified rather than assumed, since a token can merge across a plain-text
+// boundary.
+std::vector<int64_t> ChatTemplateCache::encode(
+    ov::genai::Tokenizer& tokenizer,
+    rust::Slice<const ChatMessageData> messages,
+    size_t& reused_tokens
+) {
+    reused_tokens = 0;
+    std::string conversation = render_chat(tokenizer, messages, false);
+    std::string prompt = render_chat(tokenizer, messages, true);
+
+    // A template that rewrites earlier turns once a generation prompt is added
+    // has no stable prefix to reuse
+    if (!splicing || prompt.compare(0, conversation.size(), conversation) != 0) {
+        return encode_template_text(tokenizer, prompt);
+    }
+
+    // Longest earlier conversation this one extends; the text comparison also
+    // guards against hash collisions
+    auto hashes = message_prefix_hashes(messages);
+    const Entry* prefix = nullptr;
+    for (size_t k = messages.size(); k > 0 && prefix == nullptr; --k) {
+        auto it = entries.find(hashes[k]);
+        if (it != entries.end() && conversation.compare(0, it->second.text.size(), it->second.text) == 0) {
+            prefix = &it->second;
+        }
+    }
+
+    Entry entry;
+    entry.text = conversation;
+    if (prefix != nullptr) {
+        reused_tokens = prefix->ids.size();
+        entry.ids = prefix->ids;
+        auto appended = encode_template_text(tokenizer, conversation.substr(prefix->text.size()));
+        entry.ids.insert(entry.ids.end(), appended.begin(), appended.end());
+    } else {
+        entry.ids = encode_template_text(tokenizer, conversation);
+    }
+
+    std::vector<int64_t> ids = entry.ids;
+    auto generation_prompt = encode_template_text(tokenizer, prompt.substr(conversation.size()));
+    ids.insert(ids.end(), generation_prompt.begin(), generation_prompt.end());
+
+    if (prefix != nullptr) {
+        ++splices;
+        if (splices <= VERIFIED_SPLICES || splices % VERIFY_EVERY == 0) {
+            auto full = encode_template_text(tokenizer, prompt);
+            if (full != ids) {
+                splicing = false;
+                entries.clear();
+                order.clear();
+                reused_tokens = 0;
+                return full;
+            }
+        }
+    }
+
+    uint64_t key = hashes[messages.size()];
+    if (entries.find(key) == entries.end()) {
+        order.push_back(key);
+        if (order.size() > max_entries) {
+            entries.erase(order.front());
+            order.pop_front();
+        }
+    }
+    entries[key] = std::move(entry);
+    return ids;
+}
+
+std::unique_ptr<GenerationHandleWrapper> cb_add_chat_request(
+    ContinuousBatchingWrapper& pipeline,
+    uint64_t request_id,
+    rust::Slice<const ChatMessageData> messages,
+    const GenerationConfigWrapper& config
+) {
+    size_t reused_tokens = 0;
+    auto ids = pipeline.chat_templates.encode(pipeline.tokenizer, messages, reused_tokens);
+    ov::Tensor input_ids(ov::element::i64, {1, ids.size()});
+    std::copy(ids.begin(), ids.end(), input_ids.data<int64_t>());
+
+    auto wrapper = add_tokenized_request(pipeline, request_id, input_ids, config);
+    wrapper->conversation_hit = reused_tokens > 0;
+    return wrapper;
+}
+
+void cb_step(ContinuousBatchingWrapper& pipeline) {
+    pipeline.pipeline->step();
+}
+
+KvCacheUsageData cb_cache_usage(const ContinuousBatchingWrapper& pipeline) {
+    auto metrics = pipeline.pipeline->get_metrics();
+
+    KvCacheUsageData usage;
+    usage.requests = metrics.requests;
+    usage.scheduled_requests = metrics.scheduled_requests;
+    usage.cache_usage = metrics.cache_usage;
+    usage.max_cache_usage = metrics.max_cache_usage;
+    usage.avg_cache_usage = metrics.avg_cache_usage;
+    return usage;
+}
+
+RequestProgress handle_read(GenerationHandleWrapper& handle) {
+    auto status = handle.handle->get_status();
+
+    // Each read pops the output of one pipeline step, so several steps can
+    // be drained here when the engine polls less often than it steps
+    while (handle.handle->can_read()) {
+        auto outputs = handle.handle->read();
+        if (outputs.empty()) {
+            break;
+        }
+        const auto& output = outputs.begin()->second;
+        if (!output.generated_ids.empty()) {
+            ++handle.decode_steps;
+        }
+        handle.generated_ids.insert(
+            handle.generated_ids.end(),
+            output.generated_ids.begin(),
+            output.generated_ids.end()
+        );
+        if (output.finish_reason == ov::genai::GenerationFinishReason::LENGTH) {
+            handle.finish_reason = "length";
+        }
+    }
+
+    // The scheduler drops a request it cannot fit in the KV cache; that is a
+    // failure, not a completion
+    if (status == ov::genai::GenerationStatus::IGNORED) {
+        throw std::runtime_error("Request dropped by the scheduler: out of KV cache memory");
+    }
+
+    bool finished = status != ov::genai::GenerationStatus::RUNNING;
+
+    RequestProgress progress;
+    progress.num_input_tokens = handle.num_input_tokens;
+    progress.num_generated_tokens = handle.generated_ids.size();
+    progress.estimated_prefix_blocks_hit = handle.estimated_prefix_blocks_hit;
+    progress.estimated_prefix_blocks_missed = handle.estimated_prefix_blocks_missed;
+    progress.cached_tokens = handle.cached_tokens;
+    progress.conversation_hit = handle.conversation_hit;
+    // Handles carry no speculative stats, so these are estimates: each step
+    // yields one target token plus the accepted draft tokens, and the draft
+    // model is assumed to have proposed the full num_assistant_tokens
+    if (handle.num_assistant_tokens > 0) {
+        progress.num_draft_tokens = handle.decode_steps * handle.num_assistant_tokens;
+        progress.num_accepted_tokens = handle.generated_ids.size() - handle.decode_steps;
+    } else {
+        progress.num_draft_tokens = 0;
+        progress.num_accepted_tokens = 0;
+    }
+    progress.finished = finished;
+    progress.finish_reason = rust::String(finished ? handle.finish_reason : "");
+
+    handle.text.clear();
+    handle.decoder.decode(handle.tokenizer, handle.generated_ids, handle.text, finished);
+    if (!handle.text.empty()) {
+        progress.text = rust::String::lossy(handle.text);
+    }
+    return progress;
+}
+
+void handle_cancel(GenerationHandleWrapper& handle) {
+    handle.handle->cancel();
+}
+
 // Config methods
 void config_set_max_new_tokens(GenerationConfigWrapper& config, size_t max_tokens) {
     config.config.max_new_tokens = max_tokens;
@@ -131,14 +979,178 @@ void config_set_stop_strings(GenerationConfigWrapper& config, rust::Vec<rust::St
     config.config.stop_strings = stops;
 }
 
+void config_set_num_assistant_tokens(GenerationConfigWrapper& config, size_t num_tokens) {
+    config.config.num_assistant_tokens = num_tokens;
+}
+
+void config_set_assistant_confidence_threshold(GenerationConfigWrapper& config, float threshold) {
+    config.config.assistant_confidence_threshold = threshold;
+}
+
+void config_set_max_ngram_size(GenerationConfigWrapper& config, size_t max_ngram_size) {
+    config.config.max_ngram_size = max_ngram_size;
+}
+
+void config_set_adapter(GenerationConfigWrapper& config, rust::Str name, float alpha) {
+    config.adapter = std::string(name);
+    config.adapter_alpha = alpha;
+}
+
+// Embedding methods
+ov::genai::TextEmbeddingPipeline::PoolingType parse_pooling(const std::string& pooling) {
+    if (pooling == "cls") {
+        return ov::genai::TextEmbeddingPipeline::PoolingType::CLS;
+    }
+    if (pooling == "mean") {
+        return ov::genai::TextEmbeddingPipeline::PoolingType::MEAN;
+    }
+    if (pooling == "last_token") {
+        return ov::genai::TextEmbeddingPipeline::PoolingType::LAST_TOKEN;
+    }
+    throw std::runtime_error("Unknown pooling type: " + pooling);
+}
+
+// Copy one embedding into the output buffer, scaling it to unit length.
+// Eight independent partial sums let the compiler vectorize the reduction
+// without -ffast-math; the scale loop vectorizes as is.
+void copy_l2_normalized(const float* src, float* dst, size_t dim) {
+    float partial[8] = {};
+    size_t i = 0;
+    for (; i + 8 <= dim; i += 8) {
+        for (size_t lane = 0; lane < 8; ++lane) {
+            partial[lane] += src[i + lane] * src[i + lane];
+        }
+    }
+    float sum = 0.0f;
+    for (size_t lane = 0; lane < 8; ++lane) {
+        sum += partial[lane];
+    }
+    for (; i < dim; ++i) {
+        sum += src[i] * src[i];
+    }
+
+    const float scale = sum > 0.0f ? 1.0f / std::sqrt(sum) : 0.0f;
+    for (size_t j = 0; j < dim; ++j) {
+        dst[j] = src[j] * scale;
+    }
+}
+
+std::unique_ptr<EmbeddingPipelineWrapper> create_embedding_pipeline(
+    rust::Str model_path,
+    rust::Str device,
+    rust::Slice<const PipelineProperty> properties,
+    const EmbeddingConfigData& config
+) {
+    ov::genai::TextEmbeddingPipeline::Config pipeline_config;
+    pipeline_config.pooling_type = parse_pooling(std::string(config.pooling));
+    // Normalized here instead, fused with the copy out of the result
+    pipeline_config.normalize = false;
+    if (config.max_length > 0) {
+        pipeline_config.max_length = config.max_length;
+    }
+
+    auto wrapper = std::make_unique<EmbeddingPipelineWrapper>();
+    wrapper->pipeline = std::make_unique<ov::genai::TextEmbeddingPipeline>(
+        std::string(model_path),
+        std::string(device),
+        pipeline_config,
+        to_any_map(properties)
+    );
+    wrapper->normalize = config.normalize;
+
+    // The output width is fixed per model; one warm-up call finds it and
+    // keeps the first-inference cost off the first request
+    auto probe = wrapper->pipeline->embed_documents({"warmup"});
+    wrapper->dim = std::get<std::vector<std::vector<float>>>(probe).at(0).size();
+    return wrapper;
+}
+
+size_t embedding_dim(const EmbeddingPipelineWrapper& pipeline) {
+    return pipeline.dim;
+}
+
+void embedding_embed_batch(
+    EmbeddingPipelineWrapper& pipeline,
+    rust::Slice<const rust::Str> texts,
+    rust::Slice<float> out
+) {
+    if (out.size() != texts.size() * pipeline.dim) {
+        throw std::runtime_error("Embedding output buffer has the wrong size");
+    }
+    if (texts.empty()) {
+        return;
+    }
+
+    std::vector<std::string> documents;
+    documents.reserve(texts.size());
+    for (const auto& text : texts) {
+        documents.emplace_back(text);
+    }
+
+    auto results = pipeline.pipeline->embed_documents(documents);
+    const auto& embeddings = std::get<std::vector<std::vector<float>>>(results);
+
+    float* dst = out.data();
+    for (const auto& embedding : embeddings) {
+        if (embedding.size() != pipeline.dim) {
+            throw std::runtime_error("Unexpected embedding size");
+        }
+        if (pipeline.normalize) {
+            copy_l2_normalized(embedding.data(), dst, pipeline.dim);
+        } else {
+            std::copy(embedding.begin(), embedding.end(), dst);
+        }
+        dst += pipeline.dim;
+    }
+}
+
 // Tokenizer methods
-std::unique_ptr<TokenizerWrapper> pipeline_get_tokenizer(const LLMPipelineWrapper& pipeline) {
-    return std::make_unique<TokenizerWrapper>(pipeline.pipeline->get_tokenizer());
+const TokenizerWrapper& pipeline_tokenizer(const LLMPipelineWrapper& pipeline) {
+    return pipeline.tokenizer;
 }
 
-size_t tokenizer_count_tokens(TokenizerWrapper& tokenizer, rust::Str text) {
+size_t tokenizer_count_tokens(const TokenizerWrapper& tokenizer, rust::Str text) {
     auto inputs = tokenizer.tokenizer.encode(std::string(text));
     return inputs.input_ids.get_size();
 }
 
+rust::String tokenizer_apply_chat_template(
+    const TokenizerWrapper& tokenizer,
+    rust::Slice<const ChatMessageData> messages,
+    bool add_generation_prompt
+) {
+    auto rendered = render_chat(tokenizer.tokenizer, messages, add_generation_prompt);
+    return rust::String::lossy(rendered);
+}
+
+rust::Vec<size_t> tokenizer_count_tokens_batch(const TokenizerWrapper& tokenizer, rust::Slice<const rust::Str> texts) {
+    rust::Vec<size_t> counts;
+    if (texts.empty()) {
+        return counts;
+    }
+
+    std::vector<std::string> prompts;
+    prompts.reserve(texts.size());
+    for (const auto& text : texts) {
+        prompts.emplace_back(text);
+    }
+
+    // One encode call for the whole batch; rows are padded, so count the mask
+    auto inputs = tokenizer.tokenizer.encode(prompts);
+    const auto& mask = inputs.attention_mask;
+    size_t batch = mask.get_shape()[0];
+    size_t seq_len = mask.get_shape()[1];
+    const int64_t* data = mask.data<const int64_t>();
+
+    counts.reserve(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        size_t count = 0;
+        for (size_t j = 0; j < seq_len; ++j) {
+            count += data[i * seq_len + j] != 0;
+        }
+        counts.push_back(count);
+    }
+    return counts;
+}
+
 } // namespace genai_bridge
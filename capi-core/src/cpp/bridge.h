@@ -4,36 +4,247 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <chrono>
 #include <functional>
 #include <set>
+#include <unordered_set>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+#include <variant>
+#include <unordered_map>
+#include <deque>
+#include <map>
 
 #include "rust/cxx.h"
 #include <openvino/genai/llm_pipeline.hpp>
 #include <openvino/genai/generation_config.hpp>
 #include <openvino/genai/perf_metrics.hpp>
+#include <openvino/genai/continuous_batching_pipeline.hpp>
+#include <openvino/genai/scheduler_config.hpp>
+#include <openvino/genai/lora_adapter.hpp>
+#include <openvino/genai/speculative_decoding/perf_metrics.hpp>
+#include <openvino/genai/rag/text_embedding_pipeline.hpp>
+#include <openvino/core/version.hpp>
 
 namespace genai_bridge {
 
 // Opaque wrapper types for Rust - must be fully defined in header for cxx
+struct TokenizerWrapper {
+    // Tokenizer encode/decode are internally synchronized (pooled infer
+    // requests), so the handle can be used through const references
+    mutable ov::genai::Tokenizer tokenizer;
+    TokenizerWrapper(ov::genai::Tokenizer t) : tokenizer(std::move(t)) {}
+};
+
+// Per-model settings a request falls back to when it sets none itself
+struct RequestDefaults {
+    // Speculative decoding
+    size_t num_assistant_tokens = 0;
+    size_t max_ngram_size = 0;
+    bool prompt_lookup = false;
+    // EOS and end-of-turn tokens from the model's generation config and vocabulary
+    int64_t eos_token_id = -1;
+    std::set<int64_t> stop_token_ids;
+    // LoRA adapters registered with the pipeline, by name. Requests pick one
+    // (or none) per call; the base weights are shared by all of them.
+    std::map<std::string, ov::genai::Adapter> adapters;
+};
+
 struct LLMPipelineWrapper {
-    std::unique_ptr<ov::genai::LLMPipeline> pipeline;
+    // Shared so background generations keep the pipeline alive
+    std::shared_ptr<ov::genai::LLMPipeline> pipeline;
+    // Held by every call into the pipeline. A background generation holds it
+    // for its whole run, which outlives the Rust borrow that started it.
+    std::shared_ptr<std::mutex> busy = std::make_shared<std::mutex>();
+    // Fetched once; get_tokenizer() returns a new handle on every call
+    TokenizerWrapper tokenizer;
+    RequestDefaults request_defaults;
     
-    LLMPipelineWrapper(const std::string& model_path, const std::string& device)
-        : pipeline(std::make_unique<ov::genai::LLMPipeline>(model_path, device)) {}
+    LLMPipelineWrapper(const std::string& model_path, const std::string& device, const ov::AnyMap& properties)
+        : pipeline(std::make_shared<ov::genai::LLMPipeline>(model_path, device, properties)),
+          tokenizer(pipeline->get_tokenizer()) {}
 };
 
 struct GenerationConfigWrapper {
     ov::genai::GenerationConfig config;
+    // Adapter to apply, resolved against the pipeline's registered adapters; empty for the base model
+    std::string adapter;
+    float adapter_alpha = 1.0f;
 };
 
-struct TokenizerWrapper {
+// Estimates prefix cache hits from the prompts sent to the pipeline, which
+// does not report them. Only an estimate: blocks the scheduler has evicted or
+// not yet computed still count as hits, preempted sequences are not seen, and
+// the block size is the plugin default. Two generations of blocks bound its
+// memory; the older is dropped when the newer fills, and a hit moves a block
+// into the newer one.
+struct PrefixCacheIndex {
+    size_t block_size;
+    size_t max_blocks;
+    std::unordered_set<uint64_t> blocks;
+    std::unordered_set<uint64_t> previous;
+
+    PrefixCacheIndex(size_t block_size, size_t max_blocks)
+        : block_size(block_size), max_blocks(max_blocks) {}
+
+    // Returns {hits, misses} in blocks and records the prompt's blocks
+    std::pair<size_t, size_t> lookup_and_insert(const int64_t* ids, size_t len);
+};
+
+struct ChatMessageData;
+
+// Rendered and tokenized chat-template prefixes, keyed by a hash of the
+// messages they were rendered from. A follow-up turn starts with the previous
+// conversation, so only the appended messages need tokenizing.
+struct ChatTemplateCache {
+    struct Entry {
+        std::string text;
+        std::vector<int64_t> ids;
+    };
+
+    size_t max_entries;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::deque<uint64_t> order;
+    // Spliced prompts are checked against a full encode: all of the first
+    // few, then a sample. One mismatch turns splicing off for good, since
+    // the template's boundaries do not tokenize independently.
+    size_t splices = 0;
+    bool splicing = true;
+
+    explicit ChatTemplateCache(size_t max_entries) : max_entries(max_entries) {}
+
+    // Render the messages with the generation prompt and return their token
+    // ids; `reused_tokens` is how many came from an earlier conversation
+    std::vector<int64_t> encode(
+        ov::genai::Tokenizer& tokenizer,
+        rust::Slice<const ChatMessageData> messages,
+        size_t& reused_tokens
+    );
+};
+
+struct ContinuousBatchingWrapper {
+    std::unique_ptr<ov::genai::ContinuousBatchingPipeline> pipeline;
     ov::genai::Tokenizer tokenizer;
-    TokenizerWrapper(ov::genai::Tokenizer t) : tokenizer(std::move(t)) {}
+    bool prefix_caching;
+    PrefixCacheIndex prefix_index;
+    RequestDefaults request_defaults;
+    ChatTemplateCache chat_templates;
+
+    ContinuousBatchingWrapper(
+        const std::string& model_path,
+        const std::string& device,
+        const ov::genai::SchedulerConfig& scheduler_config,
+        const ov::AnyMap& properties,
+        size_t block_size
+    )
+        : pipeline(std::make_unique<ov::genai::ContinuousBatchingPipeline>(model_path, scheduler_config, device, properties)),
+          tokenizer(pipeline->get_tokenizer()),
+          prefix_caching(scheduler_config.enable_prefix_caching),
+          prefix_index(block_size, 1 << 16),
+          chat_templates(256) {}
+};
+
+// Detokenizes a growing token sequence one window at a time. Each call
+// decodes only the tokens since the last emitted chunk, starting one chunk
+// back so word-boundary spacing matches a full decode; the cost per token
+// does not grow with the length of the output.
+struct IncrementalDecoder {
+    size_t prefix_offset = 0;
+    size_t read_offset = 0;
+    std::vector<int64_t> window;
+
+    // Appends the text completed by new tokens to `out`. An incomplete
+    // multi-byte sequence is held back until more tokens arrive or `final`.
+    void decode(ov::genai::Tokenizer& tokenizer, const std::vector<int64_t>& tokens, std::string& out, bool final);
+
+    // Start over for a new sequence, keeping the window's capacity
+    void reset() {
+        prefix_offset = 0;
+        read_offset = 0;
+    }
+};
+
+// Per-request handle; keeps the generated ids so text can be detokenized incrementally
+struct GenerationHandleWrapper {
+    ov::genai::GenerationHandle handle;
+    ov::genai::Tokenizer tokenizer;
+    std::vector<int64_t> generated_ids;
+    IncrementalDecoder decoder;
+    // Text decoded by the current read; reused across reads
+    std::string text;
+    size_t num_input_tokens = 0;
+    size_t estimated_prefix_blocks_hit = 0;
+    size_t estimated_prefix_blocks_missed = 0;
+    // Prompt tokens covered by reused KV blocks
+    size_t cached_tokens = 0;
+    // The request extended a conversation seen earlier
+    bool conversation_hit = false;
+    // Speculative decoding: tokens drafted per step and pipeline steps read so far
+    size_t num_assistant_tokens = 0;
+    size_t decode_steps = 0;
+    std::string finish_reason = "stop";
+
+    GenerationHandleWrapper(ov::genai::GenerationHandle h, ov::genai::Tokenizer t, size_t input_tokens)
+        : handle(std::move(h)), tokenizer(std::move(t)), num_input_tokens(input_tokens) {}
+};
+
+// Forward declaration of Rust type woken whenever new output is available
+struct GenerationNotifier;
+
+// State of a background generation, shared with its worker so the worker
+// can run to completion after the handle is dropped
+struct GenerationState {
+    rust::Box<GenerationNotifier> notifier;
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mutex;
+    std::string pending;
+    bool finished = false;
+    std::string error;
+    ov::genai::DecodedResults result;
+    // "stop" or "length", as the streamer saw generation end; empty until finished
+    std::string finish_reason;
+
+    explicit GenerationState(rust::Box<GenerationNotifier> notifier) : notifier(std::move(notifier)) {}
+};
+
+// Generation running on a C++-owned worker thread, which holds the pipeline's
+// lock until it is done. Decoded text is buffered until polled. Cancellation
+// is only checked by the streamer at token boundaries, so a prompt still
+// prefilling finishes its prefill before the worker stops.
+struct AsyncGenerationWrapper {
+    std::shared_ptr<GenerationState> state;
+    std::thread worker;
+
+    explicit AsyncGenerationWrapper(rust::Box<GenerationNotifier> notifier);
+    // Cancels and detaches the worker rather than waiting for it
+    ~AsyncGenerationWrapper();
+};
+
+// Embedding pipeline; pooling runs in the model graph, L2 normalization here
+struct EmbeddingPipelineWrapper {
+    std::unique_ptr<ov::genai::TextEmbeddingPipeline> pipeline;
+    size_t dim = 0;
+    bool normalize = true;
 };
 
 // Shared data struct declarations - these are defined by cxx in the generated code
 struct PerfMetricsData;
 struct GenerationResultData;
+struct BatchGenerationResultData;
+struct RequestProgress;
+struct SchedulerConfigData;
+struct KvCacheUsageData;
+struct PipelineProperty;
+struct SpeculativeConfigData;
+struct LoraAdapterData;
+struct TokenPoll;
+struct EmbeddingConfigData;
 
 // Forward declaration of Rust type
 struct StreamerCallback;
@@ -41,14 +252,24 @@ struct StreamerCallback;
 // Factory functions
 std::unique_ptr<LLMPipelineWrapper> create_pipeline(
     rust::Str model_path,
-    rust::Str device
+    rust::Str device,
+    rust::Slice<const PipelineProperty> properties,
+    const SpeculativeConfigData& speculative,
+    rust::Slice<const LoraAdapterData> adapters
 );
 
 std::unique_ptr<GenerationConfigWrapper> create_generation_config();
+rust::String openvino_version();
 
 // Tokenizer methods
-std::unique_ptr<TokenizerWrapper> pipeline_get_tokenizer(const LLMPipelineWrapper& pipeline);
-size_t tokenizer_count_tokens(TokenizerWrapper& tokenizer, rust::Str text);
+const TokenizerWrapper& pipeline_tokenizer(const LLMPipelineWrapper& pipeline);
+size_t tokenizer_count_tokens(const TokenizerWrapper& tokenizer, rust::Str text);
+rust::String tokenizer_apply_chat_template(
+    const TokenizerWrapper& tokenizer,
+    rust::Slice<const ChatMessageData> messages,
+    bool add_generation_prompt
+);
+rust::Vec<size_t> tokenizer_count_tokens_batch(const TokenizerWrapper& tokenizer, rust::Slice<const rust::Str> texts);
 
 // Pipeline methods
 rust::String pipeline_generate(
@@ -63,6 +284,12 @@ GenerationResultData pipeline_generate_with_metrics(
     const GenerationConfigWrapper& config
 );
 
+BatchGenerationResultData pipeline_generate_batch(
+    const LLMPipelineWrapper& pipeline,
+    rust::Slice<const rust::Str> prompts,
+    const GenerationConfigWrapper& config
+);
+
 GenerationResultData pipeline_generate_stream(
     const LLMPipelineWrapper& pipeline,
     rust::Str prompt,
@@ -70,9 +297,70 @@ GenerationResultData pipeline_generate_stream(
     StreamerCallback& callback
 );
 
-void pipeline_start_chat(LLMPipelineWrapper& pipeline);
+std::unique_ptr<AsyncGenerationWrapper> start_generation(
+    const LLMPipelineWrapper& pipeline,
+    rust::Str prompt,
+    const GenerationConfigWrapper& config,
+    rust::Box<GenerationNotifier> notifier
+);
+std::unique_ptr<AsyncGenerationWrapper> start_chat_generation(
+    const LLMPipelineWrapper& pipeline,
+    rust::Slice<const ChatMessageData> messages,
+    const GenerationConfigWrapper& config,
+    rust::Box<GenerationNotifier> notifier
+);
+TokenPoll poll_tokens(AsyncGenerationWrapper& generation);
+void cancel_generation(AsyncGenerationWrapper& generation);
+GenerationResultData join_generation(AsyncGenerationWrapper& generation);
+rust::String generation_finish_reason(const AsyncGenerationWrapper& generation);
+
+void pipeline_start_chat(LLMPipelineWrapper& pipeline, rust::Str system_message);
 void pipeline_finish_chat(LLMPipelineWrapper& pipeline);
 
+// Continuous batching methods
+std::unique_ptr<ContinuousBatchingWrapper> create_cb_pipeline(
+    rust::Str model_path,
+    rust::Str device,
+    const SchedulerConfigData& scheduler,
+    rust::Slice<const PipelineProperty> properties,
+    const SpeculativeConfigData& speculative,
+    rust::Slice<const LoraAdapterData> adapters
+);
+
+std::unique_ptr<GenerationHandleWrapper> cb_add_request(
+    ContinuousBatchingWrapper& pipeline,
+    uint64_t request_id,
+    rust::Str prompt,
+    const GenerationConfigWrapper& config
+);
+
+std::unique_ptr<GenerationHandleWrapper> cb_add_chat_request(
+    ContinuousBatchingWrapper& pipeline,
+    uint64_t request_id,
+    rust::Slice<const ChatMessageData> messages,
+    const GenerationConfigWrapper& config
+);
+
+void cb_step(ContinuousBatchingWrapper& pipeline);
+KvCacheUsageData cb_cache_usage(const ContinuousBatchingWrapper& pipeline);
+
+RequestProgress handle_read(GenerationHandleWrapper& handle);
+void handle_cancel(GenerationHandleWrapper& handle);
+
+// Embedding methods
+std::unique_ptr<EmbeddingPipelineWrapper> create_embedding_pipeline(
+    rust::Str model_path,
+    rust::Str device,
+    rust::Slice<const PipelineProperty> properties,
+    const EmbeddingConfigData& config
+);
+size_t embedding_dim(const EmbeddingPipelineWrapper& pipeline);
+void embedding_embed_batch(
+    EmbeddingPipelineWrapper& pipeline,
+    rust::Slice<const rust::Str> texts,
+    rust::Slice<float> out
+);
+
 // Config methods
 void config_set_max_new_tokens(GenerationConfigWrapper& config, size_t max_tokens);
 void config_set_temperature(GenerationConfigWrapper& config, float temperature);
@@ -80,5 +368,9 @@ void config_set_top_p(GenerationConfigWrapper& config, float top_p);
 void config_set_top_k(GenerationConfigWrapper& config, size_t top_k);
 void config_set_do_sample(GenerationConfigWrapper& config, bool do_sample);
 void config_set_stop_strings(GenerationConfigWrapper& config, rust::Vec<rust::String> stop_strings);
+void config_set_num_assistant_tokens(GenerationConfigWrapper& config, size_t num_tokens);
+void config_set_assistant_confidence_threshold(GenerationConfigWrapper& config, float threshold);
+void config_set_max_ngram_size(GenerationConfigWrapper& config, size_t max_ngram_size);
+void config_set_adapter(GenerationConfigWrapper& config, rust::Str name, float alpha);
 
 } // namespace genai_bridge
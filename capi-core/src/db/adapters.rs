@@ -0,0 +1,87 @@
+use anyhow::Result;
+use rusqlite::{Connection, OptionalExtension};
+use serde::{Deserialize, Serialize};
+
+/// A LoRA adapter fine-tuned from a registered base model. Adapters are
+/// loaded together with their base model and selected per request.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct AdapterRecord {
+    pub id: String,
+    pub base_model_id: String,
+    pub name: String,
+    /// Adapter weights (.safetensors)
+    pub path: String,
+    /// Blend factor used when a request does not set one
+    pub alpha: f64,
+    pub created_at: i64,
+}
+
+pub fn list_adapters(conn: &Connection, base_model_id: &str) -> Result<Vec<AdapterRecord>> {
+    let mut stmt = conn.prepare(
+        "SELECT id, base_model_id, name, path, alpha, created_at
+         FROM adapters
+         WHERE base_model_id = ?
+         ORDER BY created_at ASC"
+    )?;
+
+    let adapters = stmt.query_map([base_model_id], |row| {
+        Ok(AdapterRecord {
+            id: row.get(0)?,
+            base_model_id: row.get(1)?,
+            name: row.get(2)?,
+            path: row.get(3)?,
+            alpha: row.get(4)?,
+            created_at: row.get(5)?,
+        })
+    })?
+    .collect::<Result<Vec<_>, _>>()?;
+
+    Ok(adapters)
+}
+
+pub fn get_adapter(conn: &Connection, id: &str) -> Result<Option<AdapterRecord>> {
+    let mut stmt = conn.prepare(
+        "SELECT id, base_model_id, name, path, alpha, created_at
+         FROM adapters
+         WHERE id = ?"
+    )?;
+
+    let adapter = stmt.query_row([id], |row| {
+        Ok(AdapterRecord {
+            id: row.get(0)?,
+            base_model_id: row.get(1)?,
+            name: row.get(2)?,
+            path: row.get(3)?,
+            alpha: row.get(4)?,
+            created_at: row.get(5)?,
+        })
+    }).optional()?;
+
+    Ok(adapter)
+}
+
+pub fn insert_adapter(conn: &Connection, adapter: &AdapterRecord) -> Result<()> {
+    conn.execute(
+        "INSERT INTO adapters (id, base_model_id, name, path, alpha, created_at)
+         VALUES (?1, ?2, ?3, ?4, ?5, ?6)",
+        (
+            &adapter.id,
+            &adapter.base_model_id,
+            &adapter.name,
+            &adapter.path,
+            &adapter.alpha,
+            &adapter.created_at,
+        ),
+    )?;
+    Ok(())
+}
+
+pub fn delete_adapter(conn: &Connection, id: &str) -> Result<()> {
+    conn.execute("DELETE FROM adapters WHERE id = ?", [id])?;
+    Ok(())
+}
+
+pub fn delete_adapters_for_model(conn: &Connection, base_model_id: &str) -> Result<()> {
+    conn.execute("DELETE FROM adapters WHERE base_model_id = ?", [base_model_id])?;
+    Ok(())
+}
@@ -102,7 +102,7 @@ pub fn get_messages(conn: &Connection, session_id: &str) -> Result<Vec<ChatMessa
         "SELECT id, session_id, role, content, created_at
          FROM chat_messages
          WHERE session_id = ?
-         ORDER BY created_at ASC"
+         ORDER BY created_at ASC, rowid ASC"
     )?;
 
     let messages = stmt.query_map([session_id], |row| {
@@ -1,7 +1,9 @@
 pub mod models;
 pub mod chats;
+pub mod adapters;
 
 pub use models::ModelRecord;
+pub use adapters::AdapterRecord;
 pub use chats::{ChatSession, ChatMessage};
 
 use anyhow::Result;
@@ -54,6 +56,19 @@ impl Database {
             [],
         )?;
 
+        conn.execute(
+            "CREATE TABLE IF NOT EXISTS adapters (
+                id TEXT PRIMARY KEY,
+                base_model_id TEXT NOT NULL,
+                name TEXT NOT NULL,
+                path TEXT NOT NULL,
+                alpha REAL NOT NULL DEFAULT 1.0,
+                created_at INTEGER NOT NULL,
+                FOREIGN KEY (base_model_id) REFERENCES models(id)
+            )",
+            [],
+        )?;
+
         // Add new columns if they don't exist (migration)
         let has_estimated_memory = conn
             .prepare("SELECT estimated_memory_bytes FROM models LIMIT 1")
@@ -64,6 +79,30 @@ impl Database {
             conn.execute("ALTER TABLE models ADD COLUMN context_override INTEGER", [])?;
         }
 
+        let has_prompt_lookup = conn
+            .prepare("SELECT prompt_lookup FROM models LIMIT 1")
+            .is_ok();
+
+        if !has_prompt_lookup {
+            conn.execute("ALTER TABLE models ADD COLUMN prompt_lookup INTEGER NOT NULL DEFAULT 0", [])?;
+        }
+
+        let has_model_type = conn
+            .prepare("SELECT model_type FROM models LIMIT 1")
+            .is_ok();
+
+        if !has_model_type {
+            conn.execute("ALTER TABLE models ADD COLUMN model_type TEXT NOT NULL DEFAULT 'llm'", [])?;
+        }
+
+        let has_kv_cache_precision = conn
+            .prepare("SELECT kv_cache_precision FROM models LIMIT 1")
+            .is_ok();
+
+        if !has_kv_cache_precision {
+            conn.execute("ALTER TABLE models ADD COLUMN kv_cache_precision TEXT", [])?;
+        }
+
         Ok(Self { conn: Mutex::new(conn) })
     }
 
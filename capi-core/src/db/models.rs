@@ -2,6 +2,9 @@ use anyhow::Result;
 use rusqlite::{Connection, OptionalExtension};
 use serde::{Deserialize, Serialize};
 
+pub const MODEL_TYPE_LLM: &str = "llm";
+pub const MODEL_TYPE_EMBEDDING: &str = "embedding";
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct ModelRecord {
     pub id: String,
@@ -14,12 +17,31 @@ pub struct ModelRecord {
     pub last_used: Option<i64>,
     pub estimated_memory_bytes: Option<i64>,
     pub context_override: Option<i64>,
+    /// Serve with prompt-lookup speculative decoding
+    #[serde(default)]
+    pub prompt_lookup: bool,
+    /// "llm" or "embedding"
+    #[serde(default = "default_model_type")]
+    pub model_type: String,
+    /// KV cache precision override ("f16", "u8", "u4"); None uses the config
+    #[serde(default)]
+    pub kv_cache_precision: Option<String>,
+}
+
+fn default_model_type() -> String {
+    MODEL_TYPE_LLM.to_string()
+}
+
+impl ModelRecord {
+    pub fn is_embedding(&self) -> bool {
+        self.model_type == MODEL_TYPE_EMBEDDING
+    }
 }
 
 pub fn list_models(conn: &Connection) -> Result<Vec<ModelRecord>> {
     let mut stmt = conn.prepare(
         "SELECT id, name, path, size_bytes, quantization, context_length, created_at, last_used,
-                estimated_memory_bytes, context_override
+                estimated_memory_bytes, context_override, prompt_lookup, model_type, kv_cache_precision
          FROM models
          ORDER BY last_used DESC, created_at DESC"
     )?;
@@ -36,6 +58,9 @@ pub fn list_models(conn: &Connection) -> Result<Vec<ModelRecord>> {
             last_used: row.get(7)?,
             estimated_memory_bytes: row.get(8)?,
             context_override: row.get(9)?,
+            prompt_lookup: row.get(10)?,
+            model_type: row.get(11)?,
+            kv_cache_precision: row.get(12)?,
         })
     })?
     .collect::<Result<Vec<_>, _>>()?;
@@ -46,7 +71,7 @@ pub fn list_models(conn: &Connection) -> Result<Vec<ModelRecord>> {
 pub fn get_model(conn: &Connection, id: &str) -> Result<Option<ModelRecord>> {
     let mut stmt = conn.prepare(
         "SELECT id, name, path, size_bytes, quantization, context_length, created_at, last_used,
-                estimated_memory_bytes, context_override
+                estimated_memory_bytes, context_override, prompt_lookup, model_type, kv_cache_precision
          FROM models
          WHERE id = ?"
     )?;
@@ -63,6 +88,9 @@ pub fn get_model(conn: &Connection, id: &str) -> Result<Option<ModelRecord>> {
             last_used: row.get(7)?,
             estimated_memory_bytes: row.get(8)?,
             context_override: row.get(9)?,
+            prompt_lookup: row.get(10)?,
+            model_type: row.get(11)?,
+            kv_cache_precision: row.get(12)?,
         })
     }).optional()?;
 
@@ -72,8 +100,8 @@ pub fn get_model(conn: &Connection, id: &str) -> Result<Option<ModelRecord>> {
 pub fn insert_model(conn: &Connection, model: &ModelRecord) -> Result<()> {
     conn.execute(
         "INSERT INTO models (id, name, path, size_bytes, quantization, context_length, created_at, last_used,
-                             estimated_memory_bytes, context_override)
-         VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)",
+                             estimated_memory_bytes, context_override, prompt_lookup, model_type, kv_cache_precision)
+         VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13)",
         (
             &model.id,
             &model.name,
@@ -85,6 +113,9 @@ pub fn insert_model(conn: &Connection, model: &ModelRecord) -> Result<()> {
             &model.last_used,
             &model.estimated_memory_bytes,
             &model.context_override,
+            &model.prompt_lookup,
+            &model.model_type,
+            &model.kv_cache_precision,
         ),
     )?;
     Ok(())
@@ -98,6 +129,30 @@ pub fn update_last_used(conn: &Connection, id: &str, timestamp: i64) -> Result<(
     Ok(())
 }
 
+pub fn set_prompt_lookup(conn: &Connection, id: &str, enabled: bool) -> Result<()> {
+    conn.execute(
+        "UPDATE models SET prompt_lookup = ? WHERE id = ?",
+        (enabled, id),
+    )?;
+    Ok(())
+}
+
+pub fn set_model_type(conn: &Connection, id: &str, model_type: &str) -> Result<()> {
+    conn.execute(
+        "UPDATE models SET model_type = ? WHERE id = ?",
+        (model_type, id),
+    )?;
+    Ok(())
+}
+
+pub fn set_kv_cache_precision(conn: &Connection, id: &str, precision: Option<&str>) -> Result<()> {
+    conn.execute(
+        "UPDATE models SET kv_cache_precision = ? WHERE id = ?",
+        (precision, id),
+    )?;
+    Ok(())
+}
+
 pub fn delete_model(conn: &Connection, id: &str) -> Result<()> {
     conn.execute("DELETE FROM models WHERE id = ?", [id])?;
     Ok(())
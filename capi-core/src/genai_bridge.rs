@@ -2,6 +2,9 @@
 //!
 //! This module defines the FFI boundary between Rust and the C++ OpenVINO GenAI library.
 
+use futures::task::AtomicWaker;
+use std::sync::Arc;
+
 #[cxx::bridge(namespace = "genai_bridge")]
 pub mod ffi {
     // Shared structs (passed by value between Rust and C++)
@@ -16,6 +19,43 @@ pub mod ffi {
         pub throughput_std: f32,
         pub generate_duration_mean: f32,
         pub generate_duration_std: f32,
+        /// Time per output token, ms
+        pub tpot_mean: f32,
+        pub tpot_std: f32,
+        /// Inference time per output token, ms (excludes sampling and streaming)
+        pub ipot_mean: f32,
+        pub ipot_std: f32,
+        pub tokenization_duration_mean: f32,
+        pub tokenization_duration_std: f32,
+        pub detokenization_duration_mean: f32,
+        pub detokenization_duration_std: f32,
+        /// Model inference time for the whole generation, ms
+        pub inference_duration_mean: f32,
+        pub inference_duration_std: f32,
+        /// Latency between consecutive output tokens, ms, in generation order
+        pub itl_ms: Vec<f32>,
+        /// Arrival time of each output token relative to the first, ms
+        pub token_times_ms: Vec<f32>,
+        /// Prompt KV blocks the bridge estimates were in the prefix cache
+        /// (continuous batching only). The pipeline does not expose real
+        /// counts; zero when prefix caching is off, including with adapters.
+        pub estimated_prefix_blocks_hit: usize,
+        /// Prompt KV blocks the bridge estimates had to be prefilled.
+        pub estimated_prefix_blocks_missed: usize,
+        /// Estimated prompt tokens served from reused KV blocks instead of prefilled.
+        pub cached_tokens: usize,
+        /// Tokens proposed by the draft model or prompt lookup (speculative decoding only).
+        /// Estimated under continuous batching, which reports no speculative stats:
+        /// every step is assumed to draft the full `num_assistant_tokens`. Zero for
+        /// prompt lookup there, since steps without an n-gram match draft nothing.
+        pub num_draft_tokens: usize,
+        /// Draft tokens accepted by the target model; estimated under continuous
+        /// batching from tokens generated beyond one per step.
+        pub num_accepted_tokens: usize,
+        /// Wait before the engine admitted the request, ms (continuous batching only).
+        pub queue_time_ms: f32,
+        /// Admission to first token, ms, including steps shared with other sequences.
+        pub prefill_time_ms: f32,
     }
 
     #[derive(Debug)]
@@ -24,9 +64,123 @@ pub mod ffi {
         pub metrics: PerfMetricsData,
     }
 
+    /// Per-sequence counts for one prompt of a batched generate call.
+    #[derive(Debug, Clone, Default)]
+    pub struct SequenceMetricsData {
+        pub num_input_tokens: usize,
+        pub num_generated_tokens: usize,
+        pub score: f32,
+    }
+
+    /// Outputs of a batched generate call, in prompt order.
+    #[derive(Debug)]
+    pub struct BatchGenerationResultData {
+        pub texts: Vec<String>,
+        pub sequences: Vec<SequenceMetricsData>,
+        pub metrics: PerfMetricsData,
+    }
+
+    /// OpenVINO property passed at pipeline construction, value in string form.
+    #[derive(Debug, Clone)]
+    pub struct PipelineProperty {
+        pub key: String,
+        pub value: String,
+    }
+
+    /// Scheduler options for the continuous-batching pipeline.
+    #[derive(Debug, Clone, Default)]
+    pub struct SchedulerConfigData {
+        pub enable_prefix_caching: bool,
+        /// Split long prefills into chunks scheduled alongside running decodes
+        pub dynamic_split_fuse: bool,
+        /// Tokens processed per step across all sequences; 0 keeps the OpenVINO default
+        pub max_num_batched_tokens: usize,
+        /// KV cache size in GB, allocated as fixed blocks; 0 lets the plugin size it
+        pub cache_size_gb: usize,
+    }
+
+    /// KV block occupancy of a continuous-batching pipeline, percentages 0-100.
+    #[derive(Debug, Clone, Copy, Default)]
+    pub struct KvCacheUsageData {
+        /// Requests held by the scheduler, running or waiting for blocks
+        pub requests: usize,
+        /// Requests scheduled in the last step
+        pub scheduled_requests: usize,
+        pub cache_usage: f32,
+        pub max_cache_usage: f32,
+        pub avg_cache_usage: f32,
+    }
+
+    /// Speculative decoding mode for a pipeline; the default disables it.
+    #[derive(Debug, Clone, Default)]
+    pub struct SpeculativeConfigData {
+        /// Draft model directory; empty for none. Takes precedence over prompt lookup.
+        pub draft_model_path: String,
+        pub draft_device: String,
+        /// Draft from n-grams of the prompt instead of a draft model
+        pub prompt_lookup: bool,
+        /// Tokens drafted per step when a request does not set its own
+        pub num_assistant_tokens: usize,
+        /// Longest prompt n-gram matched in prompt-lookup mode
+        pub max_ngram_size: usize,
+    }
+
+    /// LoRA adapter registered with a pipeline at load time; requests select it by name.
+    #[derive(Debug, Clone)]
+    pub struct LoraAdapterData {
+        pub name: String,
+        /// Adapter weights (.safetensors)
+        pub path: String,
+    }
+
+    /// Incremental state of a request submitted to the continuous-batching pipeline.
+    #[derive(Debug, Clone, Default)]
+    pub struct RequestProgress {
+        pub text: String,
+        pub num_input_tokens: usize,
+        pub num_generated_tokens: usize,
+        pub finished: bool,
+        pub finish_reason: String,
+        pub estimated_prefix_blocks_hit: usize,
+        pub estimated_prefix_blocks_missed: usize,
+        pub cached_tokens: usize,
+        /// The messages extended a conversation the engine had already seen
+        pub conversation_hit: bool,
+        pub num_draft_tokens: usize,
+        pub num_accepted_tokens: usize,
+    }
+
+    /// Output drained from a background generation.
+    #[derive(Debug, Clone, Default)]
+    pub struct TokenPoll {
+        pub text: String,
+        pub finished: bool,
+    }
+
+    /// One chat message, rendered with the model's chat template in C++.
+    #[derive(Debug, Clone, Default)]
+    pub struct ChatMessageData {
+        pub role: String,
+        pub content: String,
+    }
+
+    /// Text embedding pipeline options.
+    #[derive(Debug, Clone, Default)]
+    pub struct EmbeddingConfigData {
+        /// "cls", "mean" or "last_token"
+        pub pooling: String,
+        /// Scale each embedding to unit L2 norm
+        pub normalize: bool,
+        /// Truncate inputs to this many tokens; 0 keeps the model default
+        pub max_length: usize,
+    }
+
     extern "Rust" {
         type StreamerCallback<'a>;
         fn on_token(self: &mut StreamerCallback, token: &[u8]) -> bool;
+
+        type GenerationNotifier;
+        fn notify(self: &GenerationNotifier);
     }
 
     unsafe extern "C++" {
@@ -36,14 +190,31 @@ pub mod ffi {
         type LLMPipelineWrapper;
         type GenerationConfigWrapper;
         type TokenizerWrapper;
+        type ContinuousBatchingWrapper;
+        type GenerationHandleWrapper;
+        type AsyncGenerationWrapper;
+        type EmbeddingPipelineWrapper;
 
         // Factory functions
-        fn create_pipeline(model_path: &str, device: &str) -> Result<UniquePtr<LLMPipelineWrapper>>;
+        fn create_pipeline(
+            model_path: &str,
+            device: &str,
+            properties: &[PipelineProperty],
+            speculative: &SpeculativeConfigData,
+            adapters: &[LoraAdapterData],
+        ) -> Result<UniquePtr<LLMPipelineWrapper>>;
         fn create_generation_config() -> Result<UniquePtr<GenerationConfigWrapper>>;
+        fn openvino_version() -> String;
 
         // Tokenizer methods
-        fn pipeline_get_tokenizer(pipeline: &LLMPipelineWrapper) -> UniquePtr<TokenizerWrapper>;
-        fn tokenizer_count_tokens(tokenizer: Pin<&mut TokenizerWrapper>, text: &str) -> usize;
+        fn pipeline_tokenizer(pipeline: &LLMPipelineWrapper) -> &TokenizerWrapper;
+        fn tokenizer_count_tokens(tokenizer: &TokenizerWrapper, text: &str) -> Result<usize>;
+        fn tokenizer_count_tokens_batch(tokenizer: &TokenizerWrapper, texts: &[&str]) -> Result<Vec<usize>>;
+        fn tokenizer_apply_chat_template(
+            tokenizer: &TokenizerWrapper,
+            messages: &[ChatMessageData],
+            add_generation_prompt: bool,
+        ) -> Result<String>;
 
         // Pipeline methods
         fn pipeline_generate(
@@ -58,6 +229,12 @@ pub mod ffi {
             config: &GenerationConfigWrapper,
         ) -> GenerationResultData;
 
+        fn pipeline_generate_batch(
+            pipeline: &LLMPipelineWrapper,
+            prompts: &[&str],
+            config: &GenerationConfigWrapper,
+        ) -> Result<BatchGenerationResultData>;
+
         // streaming now takes a Rust object reference
         fn pipeline_generate_stream(
             pipeline: &LLMPipelineWrapper,
@@ -66,9 +243,69 @@ pub mod ffi {
             callback: &mut StreamerCallback,
         ) -> GenerationResultData;
 
-        fn pipeline_start_chat(pipeline: Pin<&mut LLMPipelineWrapper>);
+        // Background generation on a C++-owned worker thread
+        fn start_generation(
+            pipeline: &LLMPipelineWrapper,
+            prompt: &str,
+            config: &GenerationConfigWrapper,
+            notifier: Box<GenerationNotifier>,
+        ) -> Result<UniquePtr<AsyncGenerationWrapper>>;
+        fn start_chat_generation(
+            pipeline: &LLMPipelineWrapper,
+            messages: &[ChatMessageData],
+            config: &GenerationConfigWrapper,
+            notifier: Box<GenerationNotifier>,
+        ) -> Result<UniquePtr<AsyncGenerationWrapper>>;
+        fn poll_tokens(generation: Pin<&mut AsyncGenerationWrapper>) -> TokenPoll;
+        fn cancel_generation(generation: Pin<&mut AsyncGenerationWrapper>);
+        fn join_generation(generation: Pin<&mut AsyncGenerationWrapper>) -> Result<GenerationResultData>;
+        fn generation_finish_reason(generation: &AsyncGenerationWrapper) -> String;
+
+        fn pipeline_start_chat(pipeline: Pin<&mut LLMPipelineWrapper>, system_message: &str);
         fn pipeline_finish_chat(pipeline: Pin<&mut LLMPipelineWrapper>);
 
+        // Continuous batching methods
+        fn create_cb_pipeline(
+            model_path: &str,
+            device: &str,
+            scheduler: &SchedulerConfigData,
+            properties: &[PipelineProperty],
+            speculative: &SpeculativeConfigData,
+            adapters: &[LoraAdapterData],
+        ) -> Result<UniquePtr<ContinuousBatchingWrapper>>;
+        fn cb_add_request(
+            pipeline: Pin<&mut ContinuousBatchingWrapper>,
+            request_id: u64,
+            prompt: &str,
+            config: &GenerationConfigWrapper,
+        ) -> Result<UniquePtr<GenerationHandleWrapper>>;
+        /// Renders the chat template and reuses cached prefixes from earlier turns.
+        fn cb_add_chat_request(
+            pipeline: Pin<&mut ContinuousBatchingWrapper>,
+            request_id: u64,
+            messages: &[ChatMessageData],
+            config: &GenerationConfigWrapper,
+        ) -> Result<UniquePtr<GenerationHandleWrapper>>;
+        fn cb_step(pipeline: Pin<&mut ContinuousBatchingWrapper>) -> Result<()>;
+        fn cb_cache_usage(pipeline: &ContinuousBatchingWrapper) -> KvCacheUsageData;
+        fn handle_read(handle: Pin<&mut GenerationHandleWrapper>) -> Result<RequestProgress>;
+        fn handle_cancel(handle: Pin<&mut GenerationHandleWrapper>);
+
+        // Embedding methods
+        fn create_embedding_pipeline(
+            model_path: &str,
+            device: &str,
+            properties: &[PipelineProperty],
+            config: &EmbeddingConfigData,
+        ) -> Result<UniquePtr<EmbeddingPipelineWrapper>>;
+        fn embedding_dim(pipeline: &EmbeddingPipelineWrapper) -> usize;
+        /// Embeds `texts` into `out`, row-major; `out` must hold texts.len() * dim values.
+        fn embedding_embed_batch(
+            pipeline: Pin<&mut EmbeddingPipelineWrapper>,
+            texts: &[&str],
+            out: &mut [f32],
+        ) -> Result<()>;
+
         // Config methods
         fn config_set_max_new_tokens(config: Pin<&mut GenerationConfigWrapper>, max_tokens: usize);
         fn config_set_temperature(config: Pin<&mut GenerationConfigWrapper>, temperature: f32);
@@ -76,43 +313,109 @@ pub mod ffi {
         fn config_set_top_k(config: Pin<&mut GenerationConfigWrapper>, top_k: usize);
         fn config_set_do_sample(config: Pin<&mut GenerationConfigWrapper>, do_sample: bool);
         fn config_set_stop_strings(config: Pin<&mut GenerationConfigWrapper>, stop_strings: Vec<String>);
+        fn config_set_num_assistant_tokens(config: Pin<&mut GenerationConfigWrapper>, num_tokens: usize);
+        fn config_set_assistant_confidence_threshold(config: Pin<&mut GenerationConfigWrapper>, threshold: f32);
+        fn config_set_max_ngram_size(config: Pin<&mut GenerationConfigWrapper>, max_ngram_size: usize);
+        /// Fails at generation time if the pipeline has no adapter by that name.
+        fn config_set_adapter(config: Pin<&mut GenerationConfigWrapper>, name: &str, alpha: f32);
     }
 }
 
-// The Rust struct that holds the closure and a buffer for partial UTF-8 sequences
+// The Rust struct that holds the closure and the tail of a UTF-8 sequence split across callbacks
 pub struct StreamerCallback<'a> {
     pub cb: Box<dyn FnMut(&str) -> bool + 'a>,
-    pub buffer: Vec<u8>,
+    pending: [u8; 4],
+    pending_len: usize,
 }
 
 impl<'a> StreamerCallback<'a> {
+    pub fn new<F>(cb: F) -> Self
+    where
+        F: FnMut(&str) -> bool + 'a,
+    {
+        Self {
+            cb: Box::new(cb),
+            pending: [0; 4],
+            pending_len: 0,
+        }
+    }
+
+    /// Decode the bytes in place and pass borrowed `&str` slices to the closure.
+    /// Only an incomplete trailing sequence (at most 3 bytes) is kept between calls.
     pub fn on_token(&mut self, token: &[u8]) -> bool {
-        self.buffer.extend_from_slice(token);
-        
-        // Try to decode the buffer as UTF-8
-        match String::from_utf8(self.buffer.clone()) {
-            Ok(s) => {
-                // Entire buffer is valid UTF-8
-                self.buffer.clear();
-                (self.cb)(&s)
+        let mut bytes = token;
+
+        if self.pending_len > 0 {
+            // Complete the pending sequence from the head of this chunk
+            let expected = utf8_sequence_len(self.pending[0]);
+            let take = expected.saturating_sub(self.pending_len).min(bytes.len());
+            self.pending[self.pending_len..self.pending_len + take].copy_from_slice(&bytes[..take]);
+            self.pending_len += take;
+            bytes = &bytes[take..];
+
+            if self.pending_len < expected {
+                return true;
             }
-            Err(e) => {
-                // Buffer is not valid UTF-8, but might have a valid prefix
-                let valid_up_to = e.utf8_error().valid_up_to();
-                if valid_up_to > 0 {
-                    let valid_bytes = self.buffer[..valid_up_to].to_vec();
-                    // SAFETY: valid_up_to is guaranteed to be a valid UTF-8 boundary
-                    let s = unsafe { String::from_utf8_unchecked(valid_bytes) };
-                    
-                    // Remove the valid prefix from the buffer
-                    self.buffer.drain(0..valid_up_to);
-                    
-                    (self.cb)(&s)
-                } else {
-                    // No valid UTF-8 prefix found yet, keep waiting for more bytes
-                    true
+
+            let len = std::mem::take(&mut self.pending_len);
+            // An invalid sequence is dropped rather than forwarded
+            if let Ok(s) = std::str::from_utf8(&self.pending[..len]) {
+                if !(self.cb)(s) {
+                    return false;
                 }
             }
         }
+
+        loop {
+            match std::str::from_utf8(bytes) {
+                Ok(s) => return s.is_empty() || (self.cb)(s),
+                Err(e) => {
+                    let valid_up_to = e.valid_up_to();
+                    if valid_up_to > 0 {
+                        // SAFETY: valid_up_to is guaranteed to be a valid UTF-8 boundary
+                        let s = unsafe { std::str::from_utf8_unchecked(&bytes[..valid_up_to]) };
+                        if !(self.cb)(s) {
+                            return false;
+                        }
+                    }
+
+                    match e.error_len() {
+                        // Skip invalid bytes and keep decoding
+                        Some(invalid) => bytes = &bytes[valid_up_to + invalid..],
+                        // Incomplete sequence at the end, wait for more bytes
+                        None => {
+                            let tail = &bytes[valid_up_to..];
+                            self.pending[..tail.len()].copy_from_slice(tail);
+                            self.pending_len = tail.len();
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Wakes the task polling a background generation; called from the C++ worker.
+pub struct GenerationNotifier {
+    waker: Arc<AtomicWaker>,
+}
+
+impl GenerationNotifier {
+    pub fn new(waker: Arc<AtomicWaker>) -> Self {
+        Self { waker }
+    }
+
+    pub fn notify(&self) {
+        self.waker.wake();
+    }
+}
+
+fn utf8_sequence_len(first: u8) -> usize {
+    match first {
+        0xF0..=0xF7 => 4,
+        0xE0..=0xEF => 3,
+        0xC0..=0xDF => 2,
+        _ => 1,
     }
 }
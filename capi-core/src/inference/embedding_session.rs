@@ -0,0 +1,60 @@
+use super::genai::{EmbeddingConfig, EmbeddingEngine, EmbeddingPipeline, Embeddings, MicroBatchConfig};
+use super::session::{InferenceSession, LoadStats};
+use anyhow::Result;
+use std::path::Path;
+use std::time::{Duration, Instant};
+use crate::config::EmbeddingSettings;
+
+/// A loaded embedding model. Concurrent callers share micro-batches, so the
+/// session only needs shared access.
+pub struct EmbeddingSession {
+    engine: EmbeddingEngine,
+    load_stats: LoadStats,
+}
+
+impl EmbeddingSession {
+    pub fn load(model_path: &Path, device: &str, settings: &EmbeddingSettings) -> Result<Self> {
+        let path_to_use = InferenceSession::prepare_load(model_path, device, None)?;
+        let (properties, cache) = InferenceSession::compile_cache_properties(path_to_use, device);
+        let started = Instant::now();
+
+        let config = EmbeddingConfig {
+            pooling: settings.pooling.clone(),
+            normalize: settings.normalize,
+            max_length: settings.max_length.unwrap_or(0),
+        };
+        let pipeline = EmbeddingPipeline::new(
+            path_to_use.to_str().unwrap(),
+            device,
+            &properties,
+            &config,
+        ).map_err(|e| anyhow::anyhow!("Failed to create embedding pipeline: {}", e))?;
+
+        let engine = EmbeddingEngine::new(pipeline, MicroBatchConfig {
+            max_batch_size: settings.max_batch_size,
+            batch_window: Duration::from_millis(settings.batch_window_ms),
+        })?;
+
+        Ok(Self {
+            engine,
+            load_stats: InferenceSession::finish_load(cache, started),
+        })
+    }
+
+    /// Embedding width of the model.
+    pub fn dim(&self) -> usize {
+        self.engine.dim()
+    }
+
+    pub fn load_stats(&self) -> &LoadStats {
+        &self.load_stats
+    }
+
+    pub async fn embed(&self, texts: Vec<String>) -> Result<Embeddings> {
+        Ok(self.engine.embed(texts).await?)
+    }
+
+    pub fn embed_blocking(&self, texts: Vec<String>) -> Result<Embeddings> {
+        Ok(self.engine.embed_blocking(texts)?)
+    }
+}
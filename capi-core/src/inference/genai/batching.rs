@@ -0,0 +1,586 @@
+//! Continuous-batching engine for OpenVINO GenAI.
+//!
+//! A single worker thread owns the `ContinuousBatchingPipeline` and drives it
+//! with `step()`. Requests are submitted from any thread and get their own
+//! event stream, so concurrent clients share decode steps instead of queuing
+//! behind each other.
+//!
+//! New requests are held in the worker while KV cache usage is above the
+//! admission threshold, so a full cache delays them rather than preempting
+//! running sequences. The pipeline applies one LoRA adapter selection per
+//! step, so requests are also admitted in groups that share an adapter.
+
+use super::{ChatMessage, GenAIError, Result, GenerationConfig, GenerationResult, LoraAdapter, PerfMetrics, PipelineProperty, SchedulerConfig, SpeculativeConfig};
+use crate::genai_bridge::ffi;
+use cxx::UniquePtr;
+use std::collections::VecDeque;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::mpsc as std_mpsc;
+use std::sync::{Arc, Mutex};
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+use tokio::sync::mpsc;
+
+/// Events produced for a single submitted request.
+pub enum GenerationEvent {
+    /// Newly decoded text.
+    Token(String),
+    /// Generation completed with the full text and metrics.
+    Finished {
+        result: GenerationResult,
+        finish_reason: String,
+    },
+    /// The pipeline failed while processing the request.
+    Failed(String),
+}
+
+/// Receiving side of a submitted request.
+pub type GenerationStream = mpsc::UnboundedReceiver<GenerationEvent>;
+
+/// Requests an engine accepts before refusing new ones, queued and running
+/// together. The server's request queue admits far fewer per model; this
+/// bounds the worker queue for callers that bypass it.
+const MAX_PENDING_REQUESTS: usize = 1024;
+
+/// How long a request for another adapter waits before the running adapter
+/// group stops taking new requests and drains, so groups take turns.
+const ADAPTER_TURN: Duration = Duration::from_secs(2);
+
+/// Alphas differing by less than this select the same adapter weights.
+const ALPHA_TOLERANCE: f32 = 1e-4;
+
+/// What a request asks the model to continue.
+enum PromptInput {
+    /// Raw text, tokenized as is
+    Text(String),
+    /// Messages rendered with the model's chat template
+    Chat(Vec<ChatMessage>),
+}
+
+struct Submission {
+    input: PromptInput,
+    config: GenerationConfig,
+    events: mpsc::UnboundedSender<GenerationEvent>,
+    stop: Option<Arc<AtomicBool>>,
+    submitted_at: Instant,
+    in_flight: InFlight,
+}
+
+struct ActiveRequest {
+    handle: UniquePtr<ffi::GenerationHandleWrapper>,
+    events: mpsc::UnboundedSender<GenerationEvent>,
+    stop: Option<Arc<AtomicBool>>,
+    _in_flight: InFlight,
+    text: String,
+    submitted_at: Instant,
+    admitted_at: Instant,
+    first_token_at: Option<Instant>,
+    last_step_at: Option<Instant>,
+    num_generated: usize,
+    itl_ms: Vec<f32>,
+    token_times_ms: Vec<f32>,
+}
+
+/// KV reuse across requests since the engine started.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct KvReuseStats {
+    pub requests: u64,
+    /// Chat requests that extended a conversation the engine had already seen
+    pub conversation_hits: u64,
+    pub prompt_tokens: u64,
+    /// Prompt tokens the bridge estimates were served from cached KV blocks.
+    /// The pipeline does not report prefix cache hits, so this comes from a
+    /// shadow index of the blocks it was sent: blocks the scheduler has since
+    /// evicted, or not yet computed, still count as hits, and the block size
+    /// is the plugin default rather than read from the pipeline.
+    pub estimated_cached_tokens: u64,
+}
+
+impl KvReuseStats {
+    pub fn conversation_hit_rate(&self) -> f32 {
+        if self.requests == 0 { 0.0 } else { self.conversation_hits as f32 / self.requests as f32 }
+    }
+
+    /// Estimated fraction of prompt tokens that did not need prefilling.
+    pub fn estimated_tokens_saved_rate(&self) -> f32 {
+        if self.prompt_tokens == 0 { 0.0 } else { self.estimated_cached_tokens as f32 / self.prompt_tokens as f32 }
+    }
+}
+
+#[derive(Default)]
+struct KvReuseCounters {
+    requests: AtomicU64,
+    conversation_hits: AtomicU64,
+    prompt_tokens: AtomicU64,
+    cached_tokens: AtomicU64,
+}
+
+impl KvReuseCounters {
+    fn record(&self, progress: &ffi::RequestProgress) {
+        self.requests.fetch_add(1, Ordering::Relaxed);
+        if progress.conversation_hit {
+            self.conversation_hits.fetch_add(1, Ordering::Relaxed);
+        }
+        self.prompt_tokens.fetch_add(progress.num_input_tokens as u64, Ordering::Relaxed);
+        self.cached_tokens.fetch_add(progress.cached_tokens as u64, Ordering::Relaxed);
+    }
+
+    fn snapshot(&self) -> KvReuseStats {
+        KvReuseStats {
+            requests: self.requests.load(Ordering::Relaxed),
+            conversation_hits: self.conversation_hits.load(Ordering::Relaxed),
+            prompt_tokens: self.prompt_tokens.load(Ordering::Relaxed),
+            estimated_cached_tokens: self.cached_tokens.load(Ordering::Relaxed),
+        }
+    }
+}
+
+/// KV cache occupancy as of the engine's last step.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct KvCacheUsage {
+    /// Percent of KV blocks in use
+    pub usage_pct: f32,
+    pub peak_usage_pct: f32,
+    pub avg_usage_pct: f32,
+    /// Requests inside the pipeline, including ones waiting there for blocks
+    pub running: usize,
+    /// Requests held back by admission control
+    pub queued: usize,
+}
+
+/// Ends a request early. Unlike dropping its stream, the request still
+/// finishes with the text and metrics it has so far.
+#[derive(Clone)]
+pub struct StopHandle(Arc<AtomicBool>);
+
+impl StopHandle {
+    /// Stop at the next step; a `Finished` event with finish reason "stop" follows.
+    pub fn stop(&self) {
+        self.0.store(true, Ordering::Relaxed);
+    }
+}
+
+/// Counts a request toward its engine's load from submission until it is
+/// finished, failed or abandoned, whichever way it leaves the worker.
+struct InFlight(Arc<AtomicUsize>);
+
+impl InFlight {
+    fn new(counter: &Arc<AtomicUsize>) -> Self {
+        counter.fetch_add(1, Ordering::Relaxed);
+        Self(Arc::clone(counter))
+    }
+}
+
+impl Drop for InFlight {
+    fn drop(&mut self) {
+        self.0.fetch_sub(1, Ordering::Relaxed);
+    }
+}
+
+struct PipelineHandle(UniquePtr<ffi::ContinuousBatchingWrapper>);
+
+// SAFETY: the pipeline is moved into the engine worker once and is only ever
+// touched from that thread afterwards.
+unsafe impl Send for PipelineHandle {}
+
+/// Continuous-batching engine serving many concurrent requests for one model.
+pub struct ContinuousBatchingEngine {
+    submissions: Option<std_mpsc::Sender<Submission>>,
+    worker: Option<JoinHandle<()>>,
+    kv_reuse: Arc<KvReuseCounters>,
+    kv_usage: Arc<Mutex<KvCacheUsage>>,
+    in_flight: Arc<AtomicUsize>,
+}
+
+impl ContinuousBatchingEngine {
+    /// Create the engine and start its worker thread.
+    ///
+    /// # Arguments
+    /// * `model_path` - Path to the model directory
+    /// * `device` - Device to use (e.g., "CPU", "GPU")
+    /// * `scheduler` - Scheduler options such as prefix caching
+    /// * `properties` - OpenVINO properties passed to model compilation
+    /// * `speculative` - Draft model or prompt lookup; the default disables both
+    /// * `adapters` - LoRA adapters requests can select with `GenerationConfig::set_adapter`
+    /// * `max_kv_usage_pct` - KV cache usage above which new requests wait to be admitted
+    pub fn new(
+        model_path: &str,
+        device: &str,
+        scheduler: &SchedulerConfig,
+        properties: &[PipelineProperty],
+        speculative: &SpeculativeConfig,
+        adapters: &[LoraAdapter],
+        max_kv_usage_pct: f32,
+    ) -> Result<Self> {
+        let pipeline = ffi::create_cb_pipeline(model_path, device, scheduler, properties, speculative, adapters)
+            .map_err(|e| GenAIError::General(e.to_string()))?;
+        let pipeline = PipelineHandle(pipeline);
+
+        let kv_reuse = Arc::new(KvReuseCounters::default());
+        let counters = Arc::clone(&kv_reuse);
+        let kv_usage = Arc::new(Mutex::new(KvCacheUsage::default()));
+        let usage = Arc::clone(&kv_usage);
+
+        let (tx, rx) = std_mpsc::channel();
+        let worker = std::thread::Builder::new()
+            .name("capi-cb-engine".to_string())
+            .spawn(move || run_engine(pipeline, rx, counters, usage, max_kv_usage_pct))
+            .map_err(|e| GenAIError::General(e.to_string()))?;
+
+        Ok(Self {
+            submissions: Some(tx),
+            worker: Some(worker),
+            kv_reuse,
+            kv_usage,
+            in_flight: Arc::new(AtomicUsize::new(0)),
+        })
+    }
+
+    /// Conversation and KV block reuse since the engine started.
+    pub fn kv_reuse_stats(&self) -> KvReuseStats {
+        self.kv_reuse.snapshot()
+    }
+
+    /// KV block utilization and admission queue depth.
+    pub fn kv_cache_usage(&self) -> KvCacheUsage {
+        *self.kv_usage.lock().unwrap()
+    }
+
+    /// Requests submitted and not yet finished, queued ones included.
+    pub fn in_flight(&self) -> usize {
+        self.in_flight.load(Ordering::Relaxed)
+    }
+
+    /// Submit a prompt; tokens are delivered on the returned stream as they are decoded.
+    ///
+    /// Dropping the stream cancels the request at the next step.
+    pub fn submit(&self, prompt: &str, config: GenerationConfig) -> Result<GenerationStream> {
+        self.send(PromptInput::Text(prompt.to_string()), config, None)
+    }
+
+    /// Like `submit`, with a handle to stop the request early and still get
+    /// its partial result.
+    pub fn submit_stoppable(&self, prompt: &str, config: GenerationConfig) -> Result<(GenerationStream, StopHandle)> {
+        let stop = Arc::new(AtomicBool::new(false));
+        let stream = self.send(PromptInput::Text(prompt.to_string()), config, Some(Arc::clone(&stop)))?;
+        Ok((stream, StopHandle(stop)))
+    }
+
+    /// Submit a conversation; the chat template is applied on the engine side,
+    /// reusing the tokenized prefix of earlier turns.
+    pub fn submit_chat(&self, messages: Vec<ChatMessage>, config: GenerationConfig) -> Result<GenerationStream> {
+        self.send(PromptInput::Chat(messages), config, None)
+    }
+
+    fn send(&self, input: PromptInput, config: GenerationConfig, stop: Option<Arc<AtomicBool>>) -> Result<GenerationStream> {
+        let (events, stream) = mpsc::unbounded_channel();
+        let submissions = self.submissions.as_ref()
+            .ok_or_else(|| GenAIError::Generation("Engine is shut down".to_string()))?;
+        if self.in_flight() >= MAX_PENDING_REQUESTS {
+            return Err(GenAIError::Generation(format!(
+                "Engine already has {} requests pending", MAX_PENDING_REQUESTS
+            )));
+        }
+
+        submissions.send(Submission {
+            input,
+            config,
+            events,
+            stop,
+            submitted_at: Instant::now(),
+            in_flight: InFlight::new(&self.in_flight),
+        }).map_err(|_| GenAIError::Generation("Engine worker stopped".to_string()))?;
+
+        Ok(stream)
+    }
+
+    /// Submit a prompt and block until it finishes.
+    ///
+    /// Must not be called from an async context: it parks the calling thread,
+    /// and waiting this way panics on a Tokio worker.
+    pub fn generate_blocking(&self, prompt: &str, config: GenerationConfig) -> Result<(GenerationResult, String)> {
+        let mut stream = self.submit(prompt, config)?;
+        while let Some(event) = stream.blocking_recv() {
+            match event {
+                GenerationEvent::Token(_) => {}
+                GenerationEvent::Finished { result, finish_reason } => return Ok((result, finish_reason)),
+                GenerationEvent::Failed(e) => return Err(GenAIError::Generation(e)),
+            }
+        }
+        Err(GenAIError::Generation("Engine dropped the request".to_string()))
+    }
+}
+
+impl Drop for ContinuousBatchingEngine {
+    fn drop(&mut self) {
+        // Closing the channel makes the worker cancel what is in flight and
+        // exit, so the pipeline's memory is freed by the time this returns
+        self.submissions.take();
+        if let Some(worker) = self.worker.take() {
+            worker.join().ok();
+        }
+    }
+}
+
+fn run_engine(
+    mut pipeline: PipelineHandle,
+    submissions: std_mpsc::Receiver<Submission>,
+    kv_reuse: Arc<KvReuseCounters>,
+    kv_usage: Arc<Mutex<KvCacheUsage>>,
+    max_kv_usage_pct: f32,
+) {
+    let mut active: Vec<ActiveRequest> = Vec::new();
+    let mut queued: VecDeque<Submission> = VecDeque::new();
+    let mut usage = ffi::KvCacheUsageData::default();
+    // Adapter selection shared by every active request
+    let mut adapter: Option<(String, f32)> = None;
+    let mut next_request_id: u64 = 0;
+
+    loop {
+        // Park on the channel while there is nothing to step
+        if active.is_empty() && queued.is_empty() {
+            match submissions.recv() {
+                Ok(submission) => queued.push_back(submission),
+                Err(_) => return,
+            }
+        }
+
+        loop {
+            match submissions.try_recv() {
+                Ok(submission) => queued.push_back(submission),
+                Err(std_mpsc::TryRecvError::Empty) => break,
+                // The engine was dropped, e.g. its model evicted
+                Err(std_mpsc::TryRecvError::Disconnected) => {
+                    shut_down(active, queued);
+                    return;
+                }
+            }
+        }
+
+        // Admit while the cache has headroom and the pipeline's own scheduler
+        // has nothing waiting. A request is then scheduled on the next step,
+        // so the time it spent queued here is its whole queue time. An idle
+        // pipeline always takes the next request, so one long prompt cannot
+        // stall the queue.
+        //
+        // Requests for another adapter than the running one are passed over,
+        // not waited on, so they do not hold up compatible requests behind
+        // them. Once one has waited ADAPTER_TURN the running group drains and
+        // the oldest request picks the next adapter.
+        let pipeline_waiting = usage.requests > usage.scheduled_requests;
+        let mut passed_over = Vec::new();
+        let mut draining = false;
+        while let Some(submission) = queued.pop_front() {
+            // The client gave up while queued
+            if submission.events.is_closed() {
+                continue;
+            }
+            let requested = submission.config.adapter();
+            if active.is_empty() {
+                adapter = requested.map(|(name, alpha)| (name.to_string(), alpha));
+            } else if usage.cache_usage >= max_kv_usage_pct || pipeline_waiting {
+                queued.push_front(submission);
+                break;
+            } else if draining || !same_adapter(requested, adapter.as_ref()) {
+                draining |= submission.submitted_at.elapsed() >= ADAPTER_TURN;
+                passed_over.push(submission);
+                continue;
+            }
+            admit(&mut pipeline, &mut active, &mut next_request_id, submission);
+        }
+        for submission in passed_over.into_iter().rev() {
+            queued.push_front(submission);
+        }
+
+        if active.is_empty() {
+            continue;
+        }
+
+        if let Err(e) = ffi::cb_step(pipeline.0.pin_mut()) {
+            for request in active.drain(..) {
+                request.events.send(GenerationEvent::Failed(e.to_string())).ok();
+            }
+            continue;
+        }
+
+        active.retain_mut(|request| poll_request(request, &kv_reuse));
+
+        usage = ffi::cb_cache_usage(&pipeline.0);
+        *kv_usage.lock().unwrap() = KvCacheUsage {
+            usage_pct: usage.cache_usage,
+            peak_usage_pct: usage.max_cache_usage,
+            avg_usage_pct: usage.avg_cache_usage,
+            running: usage.requests,
+            queued: queued.len(),
+        };
+    }
+}
+
+/// Fail every request the worker holds; the pipeline is freed when the worker returns.
+fn shut_down(active: Vec<ActiveRequest>, queued: VecDeque<Submission>) {
+    const UNLOADED: &str = "Model was unloaded";
+    for mut request in active {
+        ffi::handle_cancel(request.handle.pin_mut());
+        request.events.send(GenerationEvent::Failed(UNLOADED.to_string())).ok();
+    }
+    for submission in queued {
+        submission.events.send(GenerationEvent::Failed(UNLOADED.to_string())).ok();
+    }
+}
+
+fn same_adapter(requested: Option<(&str, f32)>, running: Option<&(String, f32)>) -> bool {
+    match (requested, running) {
+        (None, None) => true,
+        (Some((name, alpha)), Some((running_name, running_alpha))) => {
+            name == running_name && (alpha - running_alpha).abs() < ALPHA_TOLERANCE
+        }
+        _ => false,
+    }
+}
+
+fn admit(
+    pipeline: &mut PipelineHandle,
+    active: &mut Vec<ActiveRequest>,
+    next_request_id: &mut u64,
+    submission: Submission,
+) {
+    let request_id = *next_request_id;
+    *next_request_id += 1;
+
+    let added = match &submission.input {
+        PromptInput::Text(prompt) => {
+            ffi::cb_add_request(pipeline.0.pin_mut(), request_id, prompt, submission.config.inner())
+        }
+        PromptInput::Chat(messages) => {
+            ffi::cb_add_chat_request(pipeline.0.pin_mut(), request_id, messages, submission.config.inner())
+        }
+    };
+
+    match added {
+        Ok(handle) => active.push(ActiveRequest {
+            handle,
+            events: submission.events,
+            stop: submission.stop,
+            _in_flight: submission.in_flight,
+            text: String::new(),
+            submitted_at: submission.submitted_at,
+            admitted_at: Instant::now(),
+            first_token_at: None,
+            last_step_at: None,
+            num_generated: 0,
+            itl_ms: Vec::new(),
+            token_times_ms: Vec::new(),
+        }),
+        Err(e) => {
+            submission.events.send(GenerationEvent::Failed(e.to_string())).ok();
+        }
+    }
+}
+
+/// Forward new output for one request; returns false once it should be removed.
+fn poll_request(request: &mut ActiveRequest, kv_reuse: &KvReuseCounters) -> bool {
+    let mut progress = match ffi::handle_read(request.handle.pin_mut()) {
+        Ok(p) => p,
+        Err(e) => {
+            request.events.send(GenerationEvent::Failed(e.to_string())).ok();
+            return false;
+        }
+    };
+
+    if progress.num_generated_tokens > request.num_generated {
+        record_step(request, progress.num_generated_tokens);
+    }
+
+    if !progress.text.is_empty() {
+        request.text.push_str(&progress.text);
+
+        if request.events.send(GenerationEvent::Token(std::mem::take(&mut progress.text))).is_err() {
+            // Client went away, free the sequence's KV blocks
+            ffi::handle_cancel(request.handle.pin_mut());
+            return false;
+        }
+    }
+
+    // A stopped request ends like a finished one, with what it has so far
+    let stopped = request.stop.as_ref().is_some_and(|stop| stop.load(Ordering::Relaxed));
+    if stopped && !progress.finished {
+        ffi::handle_cancel(request.handle.pin_mut());
+        progress.finished = true;
+        progress.finish_reason = "stop".to_string();
+    }
+
+    if !progress.finished {
+        return true;
+    }
+    kv_reuse.record(&progress);
+
+    let result = GenerationResult {
+        text: std::mem::take(&mut request.text),
+        metrics: request_metrics(request, &progress),
+    };
+    request.events.send(GenerationEvent::Finished {
+        result,
+        finish_reason: progress.finish_reason,
+    }).ok();
+    false
+}
+
+/// Record token timings for a step that produced output; a step can yield
+/// several tokens with speculative decoding.
+fn record_step(request: &mut ActiveRequest, num_generated: usize) {
+    let now = Instant::now();
+    let first = *request.first_token_at.get_or_insert(now);
+
+    if let Some(last) = request.last_step_at {
+        request.itl_ms.push(now.duration_since(last).as_secs_f32() * 1000.0);
+    }
+    let offset_ms = now.duration_since(first).as_secs_f32() * 1000.0;
+    for _ in request.num_generated..num_generated {
+        request.token_times_ms.push(offset_ms);
+    }
+
+    request.last_step_at = Some(now);
+    request.num_generated = num_generated;
+}
+
+/// Per-request metrics measured on the engine side, since handles carry no PerfMetrics.
+fn request_metrics(request: &mut ActiveRequest, progress: &ffi::RequestProgress) -> PerfMetrics {
+    let total_ms = request.submitted_at.elapsed().as_secs_f32() * 1000.0;
+    let ttft_ms = request.first_token_at
+        .map(|t| t.duration_since(request.submitted_at).as_secs_f32() * 1000.0)
+        .unwrap_or(total_ms);
+    let throughput = if total_ms > 0.0 {
+        progress.num_generated_tokens as f32 / (total_ms / 1000.0)
+    } else {
+        0.0
+    };
+    let queue_ms = request.admitted_at.duration_since(request.submitted_at).as_secs_f32() * 1000.0;
+    let prefill_ms = request.first_token_at
+        .map(|t| t.duration_since(request.admitted_at).as_secs_f32() * 1000.0)
+        .unwrap_or(total_ms - queue_ms);
+    let tpot_ms = match (request.first_token_at, request.last_step_at) {
+        (Some(first), Some(last)) if progress.num_generated_tokens > 1 => {
+            last.duration_since(first).as_secs_f32() * 1000.0 / (progress.num_generated_tokens - 1) as f32
+        }
+        _ => 0.0,
+    };
+
+    PerfMetrics::from_data(ffi::PerfMetricsData {
+        num_input_tokens: progress.num_input_tokens,
+        num_generated_tokens: progress.num_generated_tokens,
+        ttft_mean: ttft_ms,
+        throughput_mean: throughput,
+        generate_duration_mean: total_ms,
+        tpot_mean: tpot_ms,
+        itl_ms: std::mem::take(&mut request.itl_ms),
+        token_times_ms: std::mem::take(&mut request.token_times_ms),
+        estimated_prefix_blocks_hit: progress.estimated_prefix_blocks_hit,
+        estimated_prefix_blocks_missed: progress.estimated_prefix_blocks_missed,
+        cached_tokens: progress.cached_tokens,
+        num_draft_tokens: progress.num_draft_tokens,
+        num_accepted_tokens: progress.num_accepted_tokens,
+        queue_time_ms: queue_ms,
+        prefill_time_ms: prefill_ms,
+        ..Default::default()
+    })
+}
@@ -7,6 +7,8 @@ use cxx::UniquePtr;
 /// Configuration for text generation parameters.
 pub struct GenerationConfig {
     inner: UniquePtr<ffi::GenerationConfigWrapper>,
+    /// Mirror of the adapter selection, for batching requests by adapter
+    adapter: Option<(String, f32)>,
 }
 
 // SAFETY: GenerationConfig wraps a UniquePtr to a C++ GenerationConfigWrapper.
@@ -21,7 +23,7 @@ impl GenerationConfig {
     pub fn new() -> Result<Self> {
         let inner = ffi::create_generation_config()
             .map_err(|e| crate::inference::genai::GenAIError::General(e.to_string()))?;
-        Ok(Self { inner })
+        Ok(Self { inner, adapter: None })
     }
 
     /// Set the maximum number of new tokens to generate.
@@ -61,6 +63,38 @@ impl GenerationConfig {
         Ok(())
     }
 
+    /// Set how many tokens the draft model proposes per step (speculative decoding).
+    pub fn set_num_assistant_tokens(&mut self, num_tokens: usize) -> Result<()> {
+        ffi::config_set_num_assistant_tokens(self.inner.pin_mut(), num_tokens);
+        Ok(())
+    }
+
+    /// Let the draft model stop proposing once its confidence drops below the threshold,
+    /// instead of drafting a fixed number of tokens.
+    pub fn set_assistant_confidence_threshold(&mut self, threshold: f32) -> Result<()> {
+        ffi::config_set_assistant_confidence_threshold(self.inner.pin_mut(), threshold);
+        Ok(())
+    }
+
+    /// Set the longest prompt n-gram to match in prompt-lookup decoding.
+    pub fn set_max_ngram_size(&mut self, max_ngram_size: usize) -> Result<()> {
+        ffi::config_set_max_ngram_size(self.inner.pin_mut(), max_ngram_size);
+        Ok(())
+    }
+
+    /// Apply a LoRA adapter registered with the pipeline, scaled by `alpha`.
+    /// Without one, pipelines that have adapters run the base model.
+    pub fn set_adapter(&mut self, name: &str, alpha: f32) -> Result<()> {
+        ffi::config_set_adapter(self.inner.pin_mut(), name, alpha);
+        self.adapter = Some((name.to_string(), alpha));
+        Ok(())
+    }
+
+    /// Selected adapter and its alpha; None runs the base model.
+    pub fn adapter(&self) -> Option<(&str, f32)> {
+        self.adapter.as_ref().map(|(name, alpha)| (name.as_str(), *alpha))
+    }
+
     /// Get a reference to the inner wrapper for FFI calls.
     pub(crate) fn inner(&self) -> &ffi::GenerationConfigWrapper {
         &self.inner
@@ -0,0 +1,237 @@
+//! Text embeddings with dynamic micro-batching.
+//!
+//! A worker thread owns the `TextEmbeddingPipeline`. Requests that arrive
+//! within a short window are merged, their texts sorted by length and cut
+//! into batches, so each batch pads to a similar length and many small
+//! requests share one inference call.
+
+use super::{EmbeddingConfig, GenAIError, PipelineProperty, Result};
+use crate::genai_bridge::ffi;
+use cxx::UniquePtr;
+use std::sync::mpsc as std_mpsc;
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+use tokio::sync::oneshot;
+
+/// Row-major embeddings, one row of `dim` values per input text.
+#[derive(Debug, Clone)]
+pub struct Embeddings {
+    pub dim: usize,
+    pub values: Vec<f32>,
+}
+
+impl Embeddings {
+    pub fn len(&self) -> usize {
+        if self.dim == 0 { 0 } else { self.values.len() / self.dim }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn rows(&self) -> impl Iterator<Item = &[f32]> {
+        self.values.chunks_exact(self.dim.max(1))
+    }
+}
+
+/// Direct access to an embedding pipeline; one batch per call.
+pub struct EmbeddingPipeline {
+    inner: UniquePtr<ffi::EmbeddingPipelineWrapper>,
+    dim: usize,
+}
+
+// SAFETY: the pipeline is only used through &mut self, so never concurrently.
+unsafe impl Send for EmbeddingPipeline {}
+
+impl EmbeddingPipeline {
+    /// Create a new embedding pipeline; runs one warm-up inference.
+    ///
+    /// # Arguments
+    /// * `model_path` - Path to the model directory
+    /// * `device` - Device to use (e.g., "CPU", "GPU")
+    /// * `properties` - OpenVINO properties passed to model compilation
+    /// * `config` - Pooling, normalization and input length
+    pub fn new(
+        model_path: &str,
+        device: &str,
+        properties: &[PipelineProperty],
+        config: &EmbeddingConfig,
+    ) -> Result<Self> {
+        let inner = ffi::create_embedding_pipeline(model_path, device, properties, config)
+            .map_err(|e| GenAIError::General(e.to_string()))?;
+        let dim = ffi::embedding_dim(&inner);
+        Ok(Self { inner, dim })
+    }
+
+    /// Embedding width of the model.
+    pub fn dim(&self) -> usize {
+        self.dim
+    }
+
+    /// Embed `texts` as a single batch.
+    pub fn embed_batch(&mut self, texts: &[&str]) -> Result<Embeddings> {
+        let mut values = vec![0.0f32; texts.len() * self.dim];
+        self.embed_into(texts, &mut values)?;
+        Ok(Embeddings { dim: self.dim, values })
+    }
+
+    fn embed_into(&mut self, texts: &[&str], out: &mut [f32]) -> Result<()> {
+        ffi::embedding_embed_batch(self.inner.pin_mut(), texts, out)
+            .map_err(|e| GenAIError::Generation(e.to_string()))
+    }
+}
+
+/// How the engine groups concurrent requests into batches.
+#[derive(Debug, Clone, Copy)]
+pub struct MicroBatchConfig {
+    /// Largest number of texts per inference call
+    pub max_batch_size: usize,
+    /// How long to wait for more requests before running a partial batch
+    pub batch_window: Duration,
+}
+
+struct EmbeddingRequest {
+    texts: Vec<String>,
+    reply: oneshot::Sender<Result<Embeddings>>,
+}
+
+/// Embedding engine serving concurrent requests for one model.
+pub struct EmbeddingEngine {
+    submissions: Option<std_mpsc::Sender<EmbeddingRequest>>,
+    worker: Option<JoinHandle<()>>,
+    dim: usize,
+}
+
+impl EmbeddingEngine {
+    /// Create the engine and start its worker thread.
+    pub fn new(pipeline: EmbeddingPipeline, batching: MicroBatchConfig) -> Result<Self> {
+        let dim = pipeline.dim();
+        let (tx, rx) = std_mpsc::channel();
+        let worker = std::thread::Builder::new()
+            .name("capi-embeddings".to_string())
+            .spawn(move || run_engine(pipeline, batching, rx))
+            .map_err(|e| GenAIError::General(e.to_string()))?;
+
+        Ok(Self {
+            submissions: Some(tx),
+            worker: Some(worker),
+            dim,
+        })
+    }
+
+    pub fn dim(&self) -> usize {
+        self.dim
+    }
+
+    /// Queue texts for embedding; the result arrives on the returned channel.
+    pub fn submit(&self, texts: Vec<String>) -> Result<oneshot::Receiver<Result<Embeddings>>> {
+        let (reply, receiver) = oneshot::channel();
+        let submissions = self.submissions.as_ref()
+            .ok_or_else(|| GenAIError::Generation("Engine is shut down".to_string()))?;
+
+        submissions.send(EmbeddingRequest { texts, reply })
+            .map_err(|_| GenAIError::Generation("Engine worker stopped".to_string()))?;
+
+        Ok(receiver)
+    }
+
+    pub async fn embed(&self, texts: Vec<String>) -> Result<Embeddings> {
+        self.submit(texts)?
+            .await
+            .map_err(|_| GenAIError::Generation("Engine dropped the request".to_string()))?
+    }
+
+    pub fn embed_blocking(&self, texts: Vec<String>) -> Result<Embeddings> {
+        self.submit(texts)?
+            .blocking_recv()
+            .map_err(|_| GenAIError::Generation("Engine dropped the request".to_string()))?
+    }
+}
+
+impl Drop for EmbeddingEngine {
+    fn drop(&mut self) {
+        self.submissions.take();
+        if let Some(worker) = self.worker.take() {
+            worker.join().ok();
+        }
+    }
+}
+
+fn run_engine(
+    mut pipeline: EmbeddingPipeline,
+    batching: MicroBatchConfig,
+    submissions: std_mpsc::Receiver<EmbeddingRequest>,
+) {
+    let max_batch_size = batching.max_batch_size.max(1);
+
+    // Park until there is work, then gather whatever else arrives in the window
+    while let Ok(first) = submissions.recv() {
+        let mut requests = vec![first];
+        let mut queued = requests[0].texts.len();
+        let deadline = Instant::now() + batching.batch_window;
+
+        while queued < max_batch_size {
+            let remaining = deadline.saturating_duration_since(Instant::now());
+            match submissions.recv_timeout(remaining) {
+                Ok(request) => {
+                    queued += request.texts.len();
+                    requests.push(request);
+                }
+                Err(_) => break,
+            }
+        }
+
+        run_round(&mut pipeline, max_batch_size, requests);
+    }
+}
+
+/// Embed every text of the gathered requests and reply to each of them.
+fn run_round(pipeline: &mut EmbeddingPipeline, max_batch_size: usize, requests: Vec<EmbeddingRequest>) {
+    let dim = pipeline.dim();
+
+    // (request, row) for every text, shortest first, so a batch only pads to
+    // the length of similar texts
+    let mut order: Vec<(usize, usize)> = requests.iter().enumerate()
+        .flat_map(|(r, request)| (0..request.texts.len()).map(move |i| (r, i)))
+        .collect();
+    order.sort_by_key(|&(r, i)| requests[r].texts[i].len());
+
+    let mut outputs: Vec<Vec<f32>> = requests.iter()
+        .map(|request| vec![0.0f32; request.texts.len() * dim])
+        .collect();
+    let mut batch_out = vec![0.0f32; max_batch_size * dim];
+
+    // A failed batch fails only the requests with a text in it
+    let mut failures: Vec<Option<String>> = vec![None; requests.len()];
+    for bucket in order.chunks(max_batch_size) {
+        let bucket: Vec<(usize, usize)> = bucket.iter().copied().filter(|&(r, _)| failures[r].is_none()).collect();
+        if bucket.is_empty() {
+            continue;
+        }
+        let texts: Vec<&str> = bucket.iter().map(|&(r, i)| requests[r].texts[i].as_str()).collect();
+        let out = &mut batch_out[..bucket.len() * dim];
+
+        if let Err(e) = pipeline.embed_into(&texts, out) {
+            let message = match e {
+                GenAIError::Generation(message) => message,
+                other => other.to_string(),
+            };
+            for &(r, _) in &bucket {
+                failures[r] = Some(message.clone());
+            }
+            continue;
+        }
+
+        for (row, &(r, i)) in out.chunks_exact(dim.max(1)).zip(&bucket) {
+            outputs[r][i * dim..(i + 1) * dim].copy_from_slice(row);
+        }
+    }
+
+    for ((request, values), failure) in requests.into_iter().zip(outputs).zip(failures) {
+        let result = match failure {
+            Some(e) => Err(GenAIError::Generation(e)),
+            None => Ok(Embeddings { dim, values }),
+        };
+        request.reply.send(result).ok();
+    }
+}
@@ -0,0 +1,117 @@
+//! Background generation exposed as an async stream.
+//!
+//! The pipeline runs on a worker thread owned by the C++ bridge, so async
+//! callers never block an executor thread on inference. The worker wakes the
+//! polling task whenever new text is decoded.
+
+use super::{ChatMessage, GenAIError, Result, GenerationConfig, GenerationResult, PerfMetrics};
+use crate::genai_bridge::{ffi, GenerationNotifier};
+use cxx::UniquePtr;
+use futures::stream::Stream;
+use futures::task::AtomicWaker;
+use std::pin::Pin;
+use std::sync::Arc;
+use std::task::{Context, Poll};
+
+/// A generation running in the background; yields decoded text chunks.
+///
+/// The worker holds the pipeline's lock for its whole run, so other calls on
+/// the pipeline wait for it instead of racing it. Cancellation is only
+/// checked at token boundaries: a prompt still prefilling finishes its
+/// prefill first. Dropping the task cancels it without waiting for the
+/// worker, which releases the pipeline once it reaches the next token.
+pub struct GenerationTask {
+    inner: UniquePtr<ffi::AsyncGenerationWrapper>,
+    waker: Arc<AtomicWaker>,
+    finished: bool,
+}
+
+// SAFETY: the wrapper's buffered state is guarded by a mutex on the C++ side
+// and cancellation is an atomic flag, so the handle can move between threads.
+unsafe impl Send for GenerationTask {}
+
+impl GenerationTask {
+    pub(crate) fn start(
+        pipeline: &ffi::LLMPipelineWrapper,
+        prompt: &str,
+        config: &GenerationConfig,
+    ) -> Result<Self> {
+        Self::spawn(|notifier| ffi::start_generation(pipeline, prompt, config.inner(), notifier))
+    }
+
+    /// Generate the next assistant turn of `messages`, formatted with the chat template.
+    pub(crate) fn start_chat(
+        pipeline: &ffi::LLMPipelineWrapper,
+        messages: &[ChatMessage],
+        config: &GenerationConfig,
+    ) -> Result<Self> {
+        Self::spawn(|notifier| ffi::start_chat_generation(pipeline, messages, config.inner(), notifier))
+    }
+
+    fn spawn<F>(start: F) -> Result<Self>
+    where
+        F: FnOnce(Box<GenerationNotifier>) -> std::result::Result<UniquePtr<ffi::AsyncGenerationWrapper>, cxx::Exception>,
+    {
+        let waker = Arc::new(AtomicWaker::new());
+        let notifier = Box::new(GenerationNotifier::new(Arc::clone(&waker)));
+
+        let inner = start(notifier)
+            .map_err(|e| GenAIError::Generation(e.to_string()))?;
+
+        Ok(Self {
+            inner,
+            waker,
+            finished: false,
+        })
+    }
+
+    /// Ask the worker to stop; the stream ends at the next token boundary.
+    pub fn cancel(&mut self) {
+        ffi::cancel_generation(self.inner.pin_mut());
+    }
+
+    /// Why generation ended, "stop" or "length", once the stream has ended;
+    /// None before that or if generation failed.
+    pub fn finish_reason(&self) -> Option<String> {
+        let reason = ffi::generation_finish_reason(&self.inner);
+        (!reason.is_empty()).then_some(reason)
+    }
+
+    /// Wait for the worker and return the full text and metrics.
+    ///
+    /// Returns immediately once the stream has ended; before that it blocks
+    /// until generation completes.
+    pub fn join(mut self) -> Result<GenerationResult> {
+        let result = ffi::join_generation(self.inner.pin_mut())
+            .map_err(|e| GenAIError::Generation(e.to_string()))?;
+
+        Ok(GenerationResult {
+            text: result.text,
+            metrics: PerfMetrics::from_data(result.metrics),
+        })
+    }
+}
+
+impl Stream for GenerationTask {
+    type Item = String;
+
+    fn poll_next(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Option<String>> {
+        let this = self.get_mut();
+        if this.finished {
+            return Poll::Ready(None);
+        }
+
+        // Register before draining so a notify between the two is not lost
+        this.waker.register(cx.waker());
+        let poll = ffi::poll_tokens(this.inner.pin_mut());
+
+        if !poll.text.is_empty() {
+            return Poll::Ready(Some(poll.text));
+        }
+        if poll.finished {
+            this.finished = true;
+            return Poll::Ready(None);
+        }
+        Poll::Pending
+    }
+}
@@ -43,6 +43,106 @@ impl PerfMetrics {
     pub fn generate_duration(&self) -> (f32, f32) {
         (self.data.generate_duration_mean, self.data.generate_duration_std)
     }
+
+    /// Get time per output token as (mean, std) in milliseconds.
+    pub fn tpot(&self) -> (f32, f32) {
+        (self.data.tpot_mean, self.data.tpot_std)
+    }
+
+    /// Get inference time per output token as (mean, std) in milliseconds.
+    pub fn ipot(&self) -> (f32, f32) {
+        (self.data.ipot_mean, self.data.ipot_std)
+    }
+
+    /// Get tokenization duration as (mean, std) in milliseconds.
+    pub fn tokenization_duration(&self) -> (f32, f32) {
+        (self.data.tokenization_duration_mean, self.data.tokenization_duration_std)
+    }
+
+    /// Get detokenization duration as (mean, std) in milliseconds.
+    pub fn detokenization_duration(&self) -> (f32, f32) {
+        (self.data.detokenization_duration_mean, self.data.detokenization_duration_std)
+    }
+
+    /// Get model inference duration as (mean, std) in milliseconds.
+    pub fn inference_duration(&self) -> (f32, f32) {
+        (self.data.inference_duration_mean, self.data.inference_duration_std)
+    }
+
+    /// Latency between consecutive output tokens in milliseconds.
+    pub fn inter_token_latencies(&self) -> &[f32] {
+        &self.data.itl_ms
+    }
+
+    /// Arrival time of each output token relative to the first, in milliseconds.
+    pub fn token_times(&self) -> &[f32] {
+        &self.data.token_times_ms
+    }
+
+    /// Inter-token latency at each given percentile (0-100), nearest rank.
+    /// Zero when fewer than two tokens were generated.
+    pub fn itl_percentiles<const N: usize>(&self, percentiles: [f32; N]) -> [f32; N] {
+        let mut sorted = self.data.itl_ms.clone();
+        sorted.sort_by(|a, b| a.total_cmp(b));
+
+        percentiles.map(|p| {
+            if sorted.is_empty() {
+                return 0.0;
+            }
+            let rank = ((p / 100.0) * sorted.len() as f32).ceil() as usize;
+            sorted[rank.clamp(1, sorted.len()) - 1]
+        })
+    }
+
+    /// Estimated prefix cache usage as (hit, missed) prompt KV blocks; see
+    /// `KvReuseStats` for what the estimate misses.
+    pub fn estimated_prefix_blocks(&self) -> (usize, usize) {
+        (self.data.estimated_prefix_blocks_hit, self.data.estimated_prefix_blocks_missed)
+    }
+
+    /// Estimated fraction of prompt KV blocks served from the prefix cache.
+    pub fn estimated_prefix_hit_rate(&self) -> f32 {
+        let total = self.data.estimated_prefix_blocks_hit + self.data.estimated_prefix_blocks_missed;
+        if total == 0 {
+            0.0
+        } else {
+            self.data.estimated_prefix_blocks_hit as f32 / total as f32
+        }
+    }
+
+    /// Estimated prompt tokens served from reused KV blocks instead of prefilled.
+    pub fn cached_tokens(&self) -> usize {
+        self.data.cached_tokens
+    }
+
+    /// Get (queue, prefill) time in ms; zero outside continuous batching.
+    pub fn queue_and_prefill_ms(&self) -> (f32, f32) {
+        (self.data.queue_time_ms, self.data.prefill_time_ms)
+    }
+
+    /// Get speculative decoding counts as (drafted, accepted) tokens.
+    pub fn speculative_tokens(&self) -> (usize, usize) {
+        (self.data.num_draft_tokens, self.data.num_accepted_tokens)
+    }
+
+    /// Fraction of draft tokens accepted by the target model.
+    pub fn acceptance_rate(&self) -> f32 {
+        if self.data.num_draft_tokens == 0 {
+            0.0
+        } else {
+            self.data.num_accepted_tokens as f32 / self.data.num_draft_tokens as f32
+        }
+    }
+
+    /// Generated tokens per target-model decode step; 1.0 without speculative decoding.
+    pub fn speculative_speedup(&self) -> f32 {
+        let steps = self.data.num_generated_tokens.saturating_sub(self.data.num_accepted_tokens);
+        if steps == 0 {
+            1.0
+        } else {
+            self.data.num_generated_tokens as f32 / steps as f32
+        }
+    }
 }
 
 impl Default for PerfMetrics {
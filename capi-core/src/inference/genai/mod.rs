@@ -6,10 +6,35 @@
 mod pipeline;
 mod config;
 mod metrics;
+mod batching;
+mod replicas;
+mod generation;
+mod embedding;
 
-pub use pipeline::{LLMPipeline, GenerationResult};
+pub use pipeline::{LLMPipeline, GenerationResult, BatchGenerationResult, BatchSequence};
 pub use config::GenerationConfig;
 pub use metrics::PerfMetrics;
+pub use batching::{ContinuousBatchingEngine, GenerationEvent, GenerationStream, KvCacheUsage, KvReuseStats, StopHandle};
+pub use replicas::{prompt_affinity, ReplicaPool, ReplicaStats};
+pub use generation::GenerationTask;
+pub use embedding::{EmbeddingEngine, EmbeddingPipeline, Embeddings, MicroBatchConfig};
+
+/// Scheduler options for the continuous-batching pipeline.
+pub use crate::genai_bridge::ffi::SchedulerConfigData as SchedulerConfig;
+pub use crate::genai_bridge::ffi::PipelineProperty;
+/// Speculative decoding mode: draft model or prompt lookup.
+pub use crate::genai_bridge::ffi::SpeculativeConfigData as SpeculativeConfig;
+/// LoRA adapter registered with a pipeline when it is loaded.
+pub use crate::genai_bridge::ffi::LoraAdapterData as LoraAdapter;
+/// A role/content pair for chat-template rendering.
+pub use crate::genai_bridge::ffi::ChatMessageData as ChatMessage;
+/// Pooling, normalization and input length for embedding models.
+pub use crate::genai_bridge::ffi::EmbeddingConfigData as EmbeddingConfig;
+
+/// Version string of the OpenVINO runtime the bridge is linked against.
+pub fn openvino_version() -> String {
+    crate::genai_bridge::ffi::openvino_version()
+}
 
 use thiserror::Error;
 
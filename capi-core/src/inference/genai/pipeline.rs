@@ -1,6 +1,6 @@
 //! LLM Pipeline wrapper for OpenVINO GenAI.
 
-use super::{GenAIError, Result, GenerationConfig, PerfMetrics};
+use super::{ChatMessage, GenerationTask, GenAIError, Result, GenerationConfig, LoraAdapter, PerfMetrics, PipelineProperty, SpeculativeConfig};
 use crate::genai_bridge::{ffi, StreamerCallback};
 use cxx::UniquePtr;
 
@@ -10,14 +10,29 @@ pub struct GenerationResult {
     pub metrics: PerfMetrics,
 }
 
+/// Output for one prompt of a batched generate call.
+pub struct BatchSequence {
+    pub text: String,
+    pub num_input_tokens: usize,
+    pub num_generated_tokens: usize,
+    pub score: f32,
+}
+
+/// Result of a batched generate call, sequences in prompt order.
+pub struct BatchGenerationResult {
+    pub sequences: Vec<BatchSequence>,
+    /// Metrics for the whole batch
+    pub metrics: PerfMetrics,
+}
+
 /// Wrapper around OpenVINO GenAI LLMPipeline for text generation.
 pub struct LLMPipeline {
     inner: UniquePtr<ffi::LLMPipelineWrapper>,
 }
 
-// SAFETY: The underlying C++ LLMPipeline is thread-safe for inference operations.
-// OpenVINO GenAI pipelines are designed to be used concurrently, with internal
-// synchronization handling concurrent access to model resources.
+// SAFETY: the bridge serializes every call into the C++ LLMPipeline on a
+// per-pipeline lock, which background generations hold until they finish,
+// so shared references never reach the pipeline concurrently.
 unsafe impl Send for LLMPipeline {}
 unsafe impl Sync for LLMPipeline {}
 
@@ -28,7 +43,24 @@ impl LLMPipeline {
     /// * `model_path` - Path to the model directory
     /// * `device` - Device to use (e.g., "CPU", "GPU", "NPU")
     pub fn new(model_path: &str, device: &str) -> Result<Self> {
-        let inner = ffi::create_pipeline(model_path, device)
+        Self::with_properties(model_path, device, &[])
+    }
+
+    /// Create a new LLMPipeline passing OpenVINO properties (e.g. `CACHE_DIR`).
+    pub fn with_properties(model_path: &str, device: &str, properties: &[PipelineProperty]) -> Result<Self> {
+        Self::with_speculative(model_path, device, properties, &SpeculativeConfig::default(), &[])
+    }
+
+    /// Create a new LLMPipeline that runs speculative decoding with a draft
+    /// model or prompt lookup, with LoRA adapters requests can switch between.
+    pub fn with_speculative(
+        model_path: &str,
+        device: &str,
+        properties: &[PipelineProperty],
+        speculative: &SpeculativeConfig,
+        adapters: &[LoraAdapter],
+    ) -> Result<Self> {
+        let inner = ffi::create_pipeline(model_path, device, properties, speculative, adapters)
             .map_err(|e| GenAIError::General(e.to_string()))?;
         
         Ok(Self { inner })
@@ -66,6 +98,40 @@ impl LLMPipeline {
         })
     }
 
+    /// Generate text with full configuration control and return performance metrics.
+    pub fn generate_with_metrics_config(&self, prompt: &str, config: &GenerationConfig) -> Result<GenerationResult> {
+        let result = ffi::pipeline_generate_with_metrics(&self.inner, prompt, config.inner());
+
+        Ok(GenerationResult {
+            text: result.text,
+            metrics: PerfMetrics::from_data(result.metrics),
+        })
+    }
+
+    /// Generate text for several prompts in a single padded batch.
+    ///
+    /// The prompts share one tokenizer call and one `generate()` call, so the
+    /// model runs each decode step for the whole batch instead of per prompt.
+    pub fn generate_batch(&self, prompts: &[&str], config: &GenerationConfig) -> Result<BatchGenerationResult> {
+        let result = ffi::pipeline_generate_batch(&self.inner, prompts, config.inner())
+            .map_err(|e| GenAIError::Generation(e.to_string()))?;
+
+        let sequences = result.texts.into_iter()
+            .zip(result.sequences)
+            .map(|(text, seq)| BatchSequence {
+                text,
+                num_input_tokens: seq.num_input_tokens,
+                num_generated_tokens: seq.num_generated_tokens,
+                score: seq.score,
+            })
+            .collect();
+
+        Ok(BatchGenerationResult {
+            sequences,
+            metrics: PerfMetrics::from_data(result.metrics),
+        })
+    }
+
     /// Generate text with streaming, calling the callback for each token.
     ///
     /// # Arguments
@@ -84,10 +150,7 @@ impl LLMPipeline {
         let mut config = GenerationConfig::new()?;
         config.set_max_new_tokens(max_tokens)?;
         
-        let mut streamer = StreamerCallback {
-            cb: Box::new(callback),
-            buffer: Vec::new(),
-        };
+        let mut streamer = StreamerCallback::new(callback);
 
         let result = ffi::pipeline_generate_stream(&self.inner, prompt, config.inner(), &mut streamer);
         
@@ -107,10 +170,7 @@ impl LLMPipeline {
     where
         F: FnMut(&str) -> bool,
     {
-        let mut streamer = StreamerCallback {
-            cb: Box::new(callback),
-            buffer: Vec::new(),
-        };
+        let mut streamer = StreamerCallback::new(callback);
 
         let result = ffi::pipeline_generate_stream(&self.inner, prompt, config.inner(), &mut streamer);
         
@@ -120,9 +180,31 @@ impl LLMPipeline {
         })
     }
 
+    /// Start generating on a background worker; text arrives on the returned stream.
+    ///
+    /// The task keeps the underlying pipeline alive, so it may outlive `self`,
+    /// and keeps it locked until done: calls such as `generate` or
+    /// `finish_chat` made meanwhile wait for the task.
+    pub fn start_generation(&self, prompt: &str, config: &GenerationConfig) -> Result<GenerationTask> {
+        GenerationTask::start(&self.inner, prompt, config)
+    }
+
+    /// Like `start_generation`, answering the last turn of a chat history.
+    ///
+    /// Outside chat mode each call prefills the whole history. In chat mode the
+    /// history seeds the chat, and later turns pass only their new message.
+    pub fn start_chat_generation(&self, messages: &[ChatMessage], config: &GenerationConfig) -> Result<GenerationTask> {
+        GenerationTask::start_chat(&self.inner, messages, config)
+    }
+
     /// Start a chat session (maintains KV cache between generations).
     pub fn start_chat(&mut self) -> Result<()> {
-        ffi::pipeline_start_chat(self.inner.pin_mut());
+        self.start_chat_with_system("")
+    }
+
+    /// Start a chat session whose history opens with `system_message`.
+    pub fn start_chat_with_system(&mut self, system_message: &str) -> Result<()> {
+        ffi::pipeline_start_chat(self.inner.pin_mut(), system_message);
         Ok(())
     }
 
@@ -134,10 +216,21 @@ impl LLMPipeline {
 
     /// Count tokens in a string using the pipeline's tokenizer.
     pub fn count_tokens(&self, text: &str) -> usize {
-        let mut tokenizer = ffi::pipeline_get_tokenizer(&self.inner);
-        if tokenizer.is_null() {
-            return 0;
-        }
-        ffi::tokenizer_count_tokens(tokenizer.pin_mut(), text)
+        let tokenizer = ffi::pipeline_tokenizer(&self.inner);
+        ffi::tokenizer_count_tokens(tokenizer, text).unwrap_or(0)
+    }
+
+    /// Render messages with the model's chat template.
+    pub fn apply_chat_template(&self, messages: &[ChatMessage], add_generation_prompt: bool) -> Result<String> {
+        let tokenizer = ffi::pipeline_tokenizer(&self.inner);
+        ffi::tokenizer_apply_chat_template(tokenizer, messages, add_generation_prompt)
+            .map_err(|e| GenAIError::General(e.to_string()))
+    }
+
+    /// Count tokens for several strings with a single tokenizer call.
+    pub fn count_tokens_batch(&self, texts: &[&str]) -> Result<Vec<usize>> {
+        let tokenizer = ffi::pipeline_tokenizer(&self.inner);
+        ffi::tokenizer_count_tokens_batch(tokenizer, texts)
+            .map_err(|e| GenAIError::General(e.to_string()))
     }
 }
@@ -0,0 +1,136 @@
+//! Several continuous-batching engines serving one model.
+//!
+//! One engine steps a single batch at a time, which on a large CPU leaves
+//! most cores idle between the memory-bound decode steps. Each replica runs
+//! its own batch on its own share of the cores.
+//!
+//! This trades memory for throughput: a replica is a whole pipeline with its
+//! own compiled weights, since GenAI cannot serve several pipelines from one
+//! compiled model. Pools are sized at load time to fit in available RAM.
+//!
+//! Prefix caches are per replica, so requests are routed by what they start
+//! with: a conversation's turns, or prompts sharing a long prefix, land on
+//! the same replica and reuse its cached blocks. A request goes to the least
+//! loaded replica instead when its own is well behind.
+
+use super::{ChatMessage, ContinuousBatchingEngine, GenerationConfig, GenerationStream, KvCacheUsage, KvReuseStats, Result, StopHandle};
+use std::collections::hash_map::DefaultHasher;
+use std::hash::{Hash, Hasher};
+
+/// Leading prompt bytes that pick a text prompt's replica
+const AFFINITY_PREFIX_BYTES: usize = 1024;
+
+/// Requests in flight a request's own replica may be ahead of the least
+/// loaded one before the request goes to the least loaded instead
+const AFFINITY_SLACK: usize = 4;
+
+/// Load and KV state of one replica.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct ReplicaStats {
+    pub index: usize,
+    /// Requests submitted and not yet finished
+    pub in_flight: usize,
+    /// Requests completed since the replica started
+    pub requests: u64,
+    pub kv_cache: KvCacheUsage,
+}
+
+pub struct ReplicaPool {
+    replicas: Vec<ContinuousBatchingEngine>,
+}
+
+impl ReplicaPool {
+    pub fn new(replicas: Vec<ContinuousBatchingEngine>) -> Self {
+        assert!(!replicas.is_empty(), "a replica pool needs at least one engine");
+        Self { replicas }
+    }
+
+    pub fn len(&self) -> usize {
+        self.replicas.len()
+    }
+
+    /// The replica `affinity` hashes to, unless it has AFFINITY_SLACK more
+    /// requests in flight than the least loaded one. Without an affinity key,
+    /// or past the slack, the replica with the fewest in flight.
+    pub fn pick(&self, affinity: Option<u64>) -> &ContinuousBatchingEngine {
+        let least_loaded = self.replicas.iter()
+            .min_by_key(|engine| engine.in_flight())
+            .expect("replica pool is never empty");
+        let Some(affinity) = affinity else {
+            return least_loaded;
+        };
+
+        let preferred = &self.replicas[(affinity % self.replicas.len() as u64) as usize];
+        if preferred.in_flight() <= least_loaded.in_flight() + AFFINITY_SLACK {
+            preferred
+        } else {
+            least_loaded
+        }
+    }
+
+    pub fn submit(&self, prompt: &str, config: GenerationConfig) -> Result<GenerationStream> {
+        self.pick(Some(prompt_affinity(prompt))).submit(prompt, config)
+    }
+
+    pub fn submit_stoppable(&self, prompt: &str, config: GenerationConfig) -> Result<(GenerationStream, StopHandle)> {
+        self.pick(Some(prompt_affinity(prompt))).submit_stoppable(prompt, config)
+    }
+
+    pub fn submit_chat(&self, messages: Vec<ChatMessage>, config: GenerationConfig) -> Result<GenerationStream> {
+        self.pick(Some(chat_affinity(&messages))).submit_chat(messages, config)
+    }
+
+    /// KV reuse summed over replicas.
+    pub fn kv_reuse_stats(&self) -> KvReuseStats {
+        self.replicas.iter().map(|engine| engine.kv_reuse_stats()).fold(KvReuseStats::default(), |total, stats| KvReuseStats {
+            requests: total.requests + stats.requests,
+            conversation_hits: total.conversation_hits + stats.conversation_hits,
+            prompt_tokens: total.prompt_tokens + stats.prompt_tokens,
+            estimated_cached_tokens: total.estimated_cached_tokens + stats.estimated_cached_tokens,
+        })
+    }
+
+    /// KV usage over the pool: mean of the replicas' usage, highest peak, and
+    /// request counts summed.
+    pub fn kv_cache_usage(&self) -> KvCacheUsage {
+        let count = self.replicas.len() as f32;
+        let mut total = KvCacheUsage::default();
+        for usage in self.replicas.iter().map(|engine| engine.kv_cache_usage()) {
+            total.usage_pct += usage.usage_pct / count;
+            total.avg_usage_pct += usage.avg_usage_pct / count;
+            total.peak_usage_pct = total.peak_usage_pct.max(usage.peak_usage_pct);
+            total.running += usage.running;
+            total.queued += usage.queued;
+        }
+        total
+    }
+
+    pub fn replica_stats(&self) -> Vec<ReplicaStats> {
+        self.replicas.iter().enumerate().map(|(index, engine)| ReplicaStats {
+            index,
+            in_flight: engine.in_flight(),
+            requests: engine.kv_reuse_stats().requests,
+            kv_cache: engine.kv_cache_usage(),
+        }).collect()
+    }
+}
+
+/// Affinity of a text prompt: its leading bytes, where shared prefixes such
+/// as instructions and few-shot examples sit.
+pub fn prompt_affinity(prompt: &str) -> u64 {
+    let prefix = &prompt.as_bytes()[..prompt.len().min(AFFINITY_PREFIX_BYTES)];
+    let mut hasher = DefaultHasher::new();
+    prefix.hash(&mut hasher);
+    hasher.finish()
+}
+
+/// Affinity of a conversation: its first two messages (typically the system
+/// prompt and opening question), which every later turn repeats.
+fn chat_affinity(messages: &[ChatMessage]) -> u64 {
+    let mut hasher = DefaultHasher::new();
+    for message in messages.iter().take(2) {
+        message.role.hash(&mut hasher);
+        message.content.hash(&mut hasher);
+    }
+    hasher.finish()
+}
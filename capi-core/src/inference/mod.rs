@@ -1,4 +1,6 @@
 mod session;
+mod embedding_session;
 pub mod genai;
 
-pub use session::{InferenceSession, InferenceMetrics};
+pub use session::{InferenceSession, InferenceMetrics, LoadStats, BatchCompletion, SessionMemory};
+pub use embedding_session::EmbeddingSession;
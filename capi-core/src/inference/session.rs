@@ -1,94 +1,383 @@
-use super::genai::LLMPipeline;
+use super::genai::{ChatMessage, ContinuousBatchingEngine, GenerationConfig, GenerationEvent, GenerationStream, GenerationTask, KvCacheUsage, KvReuseStats, LLMPipeline, LoraAdapter, PerfMetrics, PipelineProperty, prompt_affinity, ReplicaPool, ReplicaStats, SchedulerConfig, SpeculativeConfig};
 use anyhow::Result;
 use std::path::Path;
+use std::time::Instant;
 use crate::hardware::{detect_system_resources, validate_model_load, ValidationResult};
-use crate::config::Config;
-use crate::model_manager::ModelLock;
+use crate::config::{Config, KvCacheSettings};
+use crate::model_manager::{estimate_memory, estimate_memory_with_kv_cache, CacheEntry, CompileCache, KvCacheLayout, KvCachePrecision, ModelLock, GIB};
 
+#[derive(Debug, Clone, Copy, Default)]
 pub struct InferenceMetrics {
     pub tokens_per_second: f32,
     pub time_to_first_token_ms: f32,
     pub num_input_tokens: usize,
     pub num_output_tokens: usize,
+    /// Continuous batching only: wait for admission, then admission to first token
+    pub queue_time_ms: f32,
+    pub prefill_time_ms: f32,
     pub total_time_ms: f32,
+    pub time_per_output_token_ms: f32,
+    /// Inter-token latency percentiles
+    pub itl_p50_ms: f32,
+    pub itl_p90_ms: f32,
+    pub itl_p99_ms: f32,
+    /// Where the time went: tokenizer vs model
+    pub tokenization_ms: f32,
+    pub detokenization_ms: f32,
+    pub inference_ms: f32,
+    /// Speculative decoding: tokens drafted and accepted by the target model
+    pub num_draft_tokens: usize,
+    pub num_accepted_tokens: usize,
+    pub acceptance_rate: f32,
+    /// Generated tokens per target-model decode step
+    pub speculative_speedup: f32,
+}
+
+impl From<&PerfMetrics> for InferenceMetrics {
+    fn from(metrics: &PerfMetrics) -> Self {
+        let (throughput, _) = metrics.throughput();
+        let (ttft, _) = metrics.ttft();
+        let (duration, _) = metrics.generate_duration();
+        let [itl_p50, itl_p90, itl_p99] = metrics.itl_percentiles([50.0, 90.0, 99.0]);
+        let (queue_time_ms, prefill_time_ms) = metrics.queue_and_prefill_ms();
+
+        Self {
+            tokens_per_second: throughput,
+            time_to_first_token_ms: ttft,
+            num_input_tokens: metrics.num_input_tokens(),
+            num_output_tokens: metrics.num_generated_tokens(),
+            queue_time_ms,
+            prefill_time_ms,
+            total_time_ms: duration,
+            time_per_output_token_ms: metrics.tpot().0,
+            itl_p50_ms: itl_p50,
+            itl_p90_ms: itl_p90,
+            itl_p99_ms: itl_p99,
+            tokenization_ms: metrics.tokenization_duration().0,
+            detokenization_ms: metrics.detokenization_duration().0,
+            inference_ms: metrics.inference_duration().0,
+            num_draft_tokens: metrics.speculative_tokens().0,
+            num_accepted_tokens: metrics.speculative_tokens().1,
+            acceptance_rate: metrics.acceptance_rate(),
+            speculative_speedup: metrics.speculative_speedup(),
+        }
+    }
+}
+
+/// One output of a batched generate call.
+#[derive(Debug, Clone)]
+pub struct BatchCompletion {
+    pub text: String,
+    pub metrics: InferenceMetrics,
+    /// "stop" (EOS, end-of-turn token or stop string) or "length"
+    pub finish_reason: String,
+}
+
+impl BatchCompletion {
+    /// Wait for a request submitted to the batching engine to finish.
+    pub async fn collect(mut stream: GenerationStream) -> Result<Self> {
+        loop {
+            match stream.recv().await {
+                Some(GenerationEvent::Token(_)) => {}
+                Some(GenerationEvent::Finished { result, finish_reason }) => {
+                    return Ok(Self {
+                        text: result.text,
+                        metrics: InferenceMetrics::from(&result.metrics),
+                        finish_reason,
+                    });
+                }
+                Some(GenerationEvent::Failed(e)) => return Err(anyhow::anyhow!("Generation failed: {}", e)),
+                None => return Err(anyhow::anyhow!("Generation failed: engine dropped the request")),
+            }
+        }
+    }
+}
+
+/// How long the model took to become ready, split by cold compile vs cache hit.
+#[derive(Debug, Clone, Default)]
+pub struct LoadStats {
+    pub load_time_ms: f32,
+    /// Compiled blobs were already in the compile cache
+    pub cache_hit: bool,
+}
+
+/// Memory of a session: the model's weights, of which every compiled
+/// pipeline holds its own copy, and the session's KV cache.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct SessionMemory {
+    /// Size of the model's weight file; 0 when it could not be read
+    pub weight_bytes: u64,
+    /// Compiled pipelines of this session (its replicas); each holds a copy
+    /// of the weights
+    pub pipelines: usize,
+    /// Fixed KV budget of batched engines, or the current context of a
+    /// dedicated pipeline; None when neither is known
+    pub kv_cache_bytes: Option<u64>,
+}
+
+/// What a session knows at load time to size its own KV cache.
+struct MemoryLayout {
+    weight_bytes: u64,
+    kv_bytes_per_token: Option<u64>,
+    /// Total over replicas of a batched engine with a fixed cache
+    kv_budget_bytes: Option<u64>,
+}
+
+enum Engine {
+    /// Dedicated pipeline; one generation at a time, supports chat mode.
+    Pipeline(LLMPipeline),
+    /// Continuous-batching pipelines shared by concurrent requests.
+    Batched(ReplicaPool),
+}
+
+/// Stored chat the dedicated pipeline is answering.
+struct ChatState {
+    id: String,
+    /// Earlier messages of a resumed chat, sent once with its first turn;
+    /// None once chat mode holds the history in the KV cache.
+    history: Option<Vec<ChatMessage>>,
 }
 
 pub struct InferenceSession {
-    pipeline: LLMPipeline,
+    engine: Engine,
     in_chat_mode: bool,
+    chat: Option<ChatState>,
     _lock: Option<ModelLock>,
     context_tokens: usize,
+    load_stats: LoadStats,
+    speculative: SpeculativeConfig,
+    /// Names of the LoRA adapters loaded with the model
+    adapters: Vec<String>,
+    /// Adapter and alpha applied to this session's own generations
+    adapter: Option<(String, f32)>,
+    memory: MemoryLayout,
 }
 
 impl InferenceSession {
+    /// Load with the configured KV cache settings and no speculative decoding.
     pub fn load(model_path: &Path, device: &str) -> Result<Self> {
-        let path_to_use = if model_path.extension().and_then(|e| e.to_str()) == Some("gguf") {
-            model_path
-        } else if model_path.is_dir() {
-            model_path
-        } else {
-            model_path.parent()
-                .ok_or_else(|| anyhow::anyhow!("Invalid model path"))?
-        };
-
-        // Validate resources before loading
-        if let Ok(file_size) = std::fs::metadata(path_to_use).map(|m| m.len()) {
-            let estimated_memory = (file_size as f64 * 1.5) as u64;
-            let config = Config::load()?;
+        let config = Config::load()?;
+        Self::load_speculative(model_path, device, &SpeculativeConfig::default(), &config.kv_cache, &[])
+    }
 
-            if let Ok(resources) = detect_system_resources() {
-                match validate_model_load(estimated_memory, device, &resources, &config.resource_mode)? {
-                    ValidationResult::Sufficient => {},
-                    ValidationResult::Warning { message } => {
-                        eprintln!("\nWarning: {}", message);
-                        eprintln!("This may cause OOM errors or system instability.");
+    /// Load the model with speculative decoding (draft model or prompt lookup)
+    /// and the LoRA adapters generations can switch between.
+    pub fn load_speculative(
+        model_path: &Path,
+        device: &str,
+        speculative: &SpeculativeConfig,
+        kv_cache: &KvCacheSettings,
+        adapters: &[LoraAdapter],
+    ) -> Result<Self> {
+        let kv_cache = &Self::dedicated_kv_cache(kv_cache);
+        let path_to_use = Self::prepare_load(model_path, device, Some(kv_cache))?;
+        let (mut properties, cache) = Self::compile_cache_properties(path_to_use, device);
+        properties.extend(Self::kv_cache_properties(kv_cache)?);
+        let speculative = Self::resolve_speculative(speculative)?;
+        let memory = Self::memory_layout(path_to_use, kv_cache, None)?;
+        let started = Instant::now();
 
-                        if matches!(config.resource_mode, crate::hardware::ResourceMode::Loose) {
-                            eprintln!("Warning: Resource mode is Loose. Continuing despite potential memory pressure.");
-                        }
-                    },
-                    ValidationResult::Insufficient { message } => {
-                        return Err(anyhow::anyhow!(
-                            "Insufficient memory to load model\n\n{}\n\nSuggestions:\n\
-                            - Close other applications to free memory\n\
-                            - Try a more quantized version (Q3_K_M, Q2_K)\n\
-                            - Use a smaller model\n\
-                            - Change resource mode: capi config set-resource-mode loose",
-                            message
-                        ));
-                    },
-                }
-            }
-        }
-
-        let pipeline = LLMPipeline::new(
+        let pipeline = LLMPipeline::with_speculative(
             path_to_use.to_str().unwrap(),
             device,
+            &properties,
+            &speculative,
+            adapters,
         ).map_err(|e| anyhow::anyhow!("Failed to create pipeline: {}", e))?;
 
         Ok(Self {
-            pipeline,
+            engine: Engine::Pipeline(pipeline),
+            in_chat_mode: false,
+            chat: None,
+            _lock: None,
+            context_tokens: 0,
+            load_stats: Self::finish_load(cache, started),
+            speculative,
+            adapters: Self::adapter_names(adapters),
+            adapter: None,
+            memory,
+        })
+    }
+
+    /// Load the model behind `replicas` continuous-batching engines so
+    /// concurrent requests can be served through `submit` without exclusive
+    /// access. Each replica gets an equal share of the KV cache budget.
+    pub fn load_batched(
+        model_path: &Path,
+        device: &str,
+        speculative: &SpeculativeConfig,
+        kv_cache: &KvCacheSettings,
+        adapters: &[LoraAdapter],
+        replicas: usize,
+    ) -> Result<Self> {
+        let replicas = replicas.max(1);
+        if let Some(budget_gb) = kv_cache.budget_gb.filter(|gb| *gb < replicas) {
+            return Err(anyhow::anyhow!(
+                "A {} GiB KV cache budget cannot be split across {} replicas; each needs at least 1 GiB",
+                budget_gb, replicas
+            ));
+        }
+        let path_to_use = Self::prepare_load(model_path, device, Some(kv_cache))?;
+        let config = Config::load()?;
+
+        // Cached blocks are matched by tokens alone, so with adapters they
+        // would be reused across requests that computed them differently
+        let scheduler = SchedulerConfig {
+            enable_prefix_caching: config.scheduler.enable_prefix_caching && adapters.is_empty(),
+            dynamic_split_fuse: config.scheduler.chunked_prefill,
+            // Without chunking the budget must cover whole prompts; OpenVINO sizes it
+            max_num_batched_tokens: if config.scheduler.chunked_prefill { config.scheduler.max_batched_tokens } else { 0 },
+            cache_size_gb: kv_cache.budget_gb.map(|gb| gb / replicas).unwrap_or(0),
+        };
+
+        let (mut properties, cache) = Self::compile_cache_properties(path_to_use, device);
+        properties.extend(Self::kv_cache_properties(kv_cache)?);
+        properties.extend(Self::replica_properties(device, replicas));
+        let speculative = Self::resolve_speculative(speculative)?;
+        let kv_budget_bytes = (scheduler.cache_size_gb > 0)
+            .then(|| scheduler.cache_size_gb as u64 * GIB * replicas as u64);
+        let memory = Self::memory_layout(path_to_use, kv_cache, kv_budget_bytes)?;
+        let started = Instant::now();
+
+        // Each replica holds its own copy of the weights; later ones import
+        // the blob the first one left in the compile cache
+        let mut engines = Vec::with_capacity(replicas);
+        for _ in 0..replicas {
+            engines.push(ContinuousBatchingEngine::new(
+                path_to_use.to_str().unwrap(),
+                device,
+                &scheduler,
+                &properties,
+                &speculative,
+                adapters,
+                config.scheduler.admission_kv_usage_pct,
+            ).map_err(|e| anyhow::anyhow!("Failed to create pipeline: {}", e))?);
+        }
+
+        Ok(Self {
+            engine: Engine::Batched(ReplicaPool::new(engines)),
             in_chat_mode: false,
+            chat: None,
             _lock: None,
             context_tokens: 0,
+            load_stats: Self::finish_load(cache, started),
+            speculative,
+            adapters: Self::adapter_names(adapters),
+            adapter: None,
+            memory,
         })
     }
 
-    pub fn load_with_lock(model_path: &Path, device: &str, model_id: &str) -> Result<Self> {
+    pub fn load_with_lock(
+        model_path: &Path,
+        device: &str,
+        model_id: &str,
+        kv_cache: &KvCacheSettings,
+        adapters: &[LoraAdapter],
+    ) -> Result<Self> {
         let lock = ModelLock::try_acquire(model_id)?;
 
-        let path_to_use = if model_path.extension().and_then(|e| e.to_str()) == Some("gguf") {
-            model_path
-        } else if model_path.is_dir() {
-            model_path
+        let kv_cache = &Self::dedicated_kv_cache(kv_cache);
+        let path_to_use = Self::prepare_load(model_path, device, Some(kv_cache))?;
+        let (mut properties, cache) = Self::compile_cache_properties(path_to_use, device);
+        properties.extend(Self::kv_cache_properties(kv_cache)?);
+        let memory = Self::memory_layout(path_to_use, kv_cache, None)?;
+        let started = Instant::now();
+
+        let pipeline = LLMPipeline::with_speculative(
+            path_to_use.to_str().unwrap(),
+            device,
+            &properties,
+            &SpeculativeConfig::default(),
+            adapters,
+        ).map_err(|e| {
+            anyhow::anyhow!("Failed to create pipeline: {}", e)
+        })?;
+
+        Ok(Self {
+            engine: Engine::Pipeline(pipeline),
+            in_chat_mode: false,
+            chat: None,
+            _lock: Some(lock),
+            context_tokens: 0,
+            load_stats: Self::finish_load(cache, started),
+            speculative: SpeculativeConfig::default(),
+            adapters: Self::adapter_names(adapters),
+            adapter: None,
+            memory,
+        })
+    }
+
+    fn memory_layout(model_dir: &Path, kv_cache: &KvCacheSettings, kv_budget_bytes: Option<u64>) -> Result<MemoryLayout> {
+        // A GGUF file holds the weights itself; an IR directory keeps them in
+        // openvino_model.bin
+        let weights = if model_dir.is_dir() { model_dir.join("openvino_model.bin") } else { model_dir.to_path_buf() };
+        Ok(MemoryLayout {
+            weight_bytes: std::fs::metadata(weights).map(|m| m.len()).unwrap_or(0),
+            kv_bytes_per_token: Self::kv_bytes_per_token(model_dir, kv_cache)?,
+            kv_budget_bytes,
+        })
+    }
+
+    /// The model's weights, this session's pipeline count, and its own KV cache.
+    pub fn memory_usage(&self) -> SessionMemory {
+        let (pipelines, kv_cache_bytes) = match &self.engine {
+            Engine::Batched(engines) => (engines.len(), self.memory.kv_budget_bytes),
+            Engine::Pipeline(_) => (1, self.memory.kv_bytes_per_token.map(|per_token| per_token * self.context_tokens as u64)),
+        };
+
+        SessionMemory {
+            weight_bytes: self.memory.weight_bytes,
+            pipelines,
+            kv_cache_bytes,
+        }
+    }
+
+    fn adapter_names(adapters: &[LoraAdapter]) -> Vec<String> {
+        adapters.iter().map(|adapter| adapter.name.clone()).collect()
+    }
+
+    /// Resolve the path handed to OpenVINO: GGUF files and directories as-is,
+    /// otherwise the directory containing the file.
+    fn model_dir(model_path: &Path) -> Result<&Path> {
+        if model_path.extension().and_then(|e| e.to_str()) == Some("gguf") || model_path.is_dir() {
+            Ok(model_path)
         } else {
             model_path.parent()
-                .ok_or_else(|| anyhow::anyhow!("Invalid model path"))?
-        };
+                .ok_or_else(|| anyhow::anyhow!("Invalid model path"))
+        }
+    }
+
+    fn resolve_speculative(speculative: &SpeculativeConfig) -> Result<SpeculativeConfig> {
+        let mut resolved = speculative.clone();
+        if !resolved.draft_model_path.is_empty() {
+            let draft_dir = Self::model_dir(Path::new(&speculative.draft_model_path))?;
+            resolved.draft_model_path = draft_dir.to_string_lossy().to_string();
+        }
+        Ok(resolved)
+    }
+
+    /// Resolve the path handed to OpenVINO and check there is enough memory to load it.
+    /// LLMs pass their KV cache settings so the cache is sized for the default context,
+    /// or at its budget when one is set.
+    pub(super) fn prepare_load<'a>(model_path: &'a Path, device: &str, kv_cache: Option<&KvCacheSettings>) -> Result<&'a Path> {
+        let path_to_use = Self::model_dir(model_path)?;
 
+        // Validate resources before loading
         if let Ok(file_size) = std::fs::metadata(path_to_use).map(|m| m.len()) {
-            let estimated_memory = (file_size as f64 * 1.5) as u64;
             let config = Config::load()?;
+            let context_length = kv_cache.and_then(|kv_cache| kv_cache.context_length)
+                .unwrap_or(config.default_context_length);
+            let estimated_memory = match kv_cache {
+                Some(KvCacheSettings { budget_gb: Some(budget_gb), .. }) => {
+                    estimate_memory_with_kv_cache(file_size, *budget_gb as u64 * GIB)?
+                }
+                Some(kv_cache) => {
+                    let kv_bytes_per_token = Self::kv_bytes_per_token(path_to_use, kv_cache)?;
+                    estimate_memory(file_size, kv_bytes_per_token, context_length)?
+                }
+                None => estimate_memory(file_size, None, context_length)?,
+            }.estimated_runtime_bytes;
 
             if let Ok(resources) = detect_system_resources() {
                 match validate_model_load(estimated_memory, device, &resources, &config.resource_mode)? {
@@ -115,101 +404,478 @@ impl InferenceSession {
             }
         }
 
-        let pipeline = LLMPipeline::new(
-            path_to_use.to_str().unwrap(),
-            device,
-        ).map_err(|e| {
-            anyhow::anyhow!("Failed to create pipeline: {}", e)
-        })?;
+        Ok(path_to_use)
+    }
 
-        Ok(Self {
-            pipeline,
-            in_chat_mode: false,
-            _lock: Some(lock),
-            context_tokens: 0,
-        })
+    /// The KV budget sizes continuous-batching caches only; dedicated pipelines
+    /// grow theirs with the conversation.
+    fn dedicated_kv_cache(kv_cache: &KvCacheSettings) -> KvCacheSettings {
+        KvCacheSettings { budget_gb: None, ..kv_cache.clone() }
+    }
+
+    /// KV cache bytes per token for a model under these settings; None if its shape is unknown.
+    pub fn kv_bytes_per_token(model_path: &Path, kv_cache: &KvCacheSettings) -> Result<Option<u64>> {
+        let precision = KvCachePrecision::parse(&kv_cache.precision)?;
+        Ok(KvCacheLayout::from_model_dir(model_path)
+            .map(|layout| layout.bytes_per_token(precision, kv_cache.group_size)))
+    }
+
+    /// Split the CPU's cores between replicas so their steps run side by side
+    /// instead of contending for every core; other devices schedule their own.
+    fn replica_properties(device: &str, replicas: usize) -> Vec<PipelineProperty> {
+        if replicas <= 1 || !device.starts_with("CPU") {
+            return Vec::new();
+        }
+        let cores = std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1);
+        vec![
+            PipelineProperty { key: "NUM_STREAMS".to_string(), value: "1".to_string() },
+            PipelineProperty { key: "INFERENCE_NUM_THREADS".to_string(), value: (cores / replicas).max(1).to_string() },
+        ]
+    }
+
+    /// Compile properties selecting the KV cache precision; none for "auto".
+    fn kv_cache_properties(kv_cache: &KvCacheSettings) -> Result<Vec<PipelineProperty>> {
+        let property = |key: &str, value: &str| PipelineProperty {
+            key: key.to_string(),
+            value: value.to_string(),
+        };
+
+        let precision = KvCachePrecision::parse(&kv_cache.precision)?;
+        let mut properties = match precision {
+            KvCachePrecision::Auto => return Ok(Vec::new()),
+            KvCachePrecision::F16 | KvCachePrecision::U8 => vec![property("KV_CACHE_PRECISION", precision.as_str())],
+            // u4 is only selectable per cache, not through the combined hint
+            KvCachePrecision::U4 => vec![
+                property("KEY_CACHE_PRECISION", "u4"),
+                property("VALUE_CACHE_PRECISION", "u4"),
+            ],
+        };
+
+        if let (Some(group_size), KvCachePrecision::U8 | KvCachePrecision::U4) = (kv_cache.group_size, precision) {
+            properties.push(property("KEY_CACHE_GROUP_SIZE", &group_size.to_string()));
+            properties.push(property("VALUE_CACHE_GROUP_SIZE", &group_size.to_string()));
+        }
+        Ok(properties)
+    }
+
+    /// Point OpenVINO at this model's compiled-blob cache entry.
+    /// Cache failures are not fatal; the model is then compiled without caching.
+    pub(super) fn compile_cache_properties(model_path: &Path, device: &str) -> (Vec<PipelineProperty>, Option<(CompileCache, CacheEntry)>) {
+        let cache = match Config::load() {
+            Ok(config) => CompileCache::new(&config),
+            Err(_) => return (Vec::new(), None),
+        };
+
+        match cache.prepare(model_path, device) {
+            Ok(entry) => {
+                let properties = vec![PipelineProperty {
+                    key: "CACHE_DIR".to_string(),
+                    value: entry.dir.to_string_lossy().to_string(),
+                }];
+                (properties, Some((cache, entry)))
+            }
+            Err(_) => (Vec::new(), None),
+        }
+    }
+
+    pub(super) fn finish_load(cache: Option<(CompileCache, CacheEntry)>, started: Instant) -> LoadStats {
+        let load_time_ms = started.elapsed().as_secs_f32() * 1000.0;
+
+        let cache_hit = match cache {
+            Some((cache, entry)) => {
+                if let Ok(removed) = cache.evict(&entry.dir) {
+                    for dir in removed {
+                        eprintln!("Evicted compiled model cache entry: {}", dir.display());
+                    }
+                }
+                entry.warm
+            }
+            None => false,
+        };
+
+        LoadStats { load_time_ms, cache_hit }
+    }
+
+    /// Load time and whether compilation was served from the compile cache.
+    pub fn load_stats(&self) -> &LoadStats {
+        &self.load_stats
+    }
+
+    fn pipeline(&self) -> Result<&LLMPipeline> {
+        match &self.engine {
+            Engine::Pipeline(pipeline) => Ok(pipeline),
+            Engine::Batched(_) => Err(anyhow::anyhow!("Operation requires a dedicated pipeline")),
+        }
+    }
+
+    fn pipeline_mut(&mut self) -> Result<&mut LLMPipeline> {
+        match &mut self.engine {
+            Engine::Pipeline(pipeline) => Ok(pipeline),
+            Engine::Batched(_) => Err(anyhow::anyhow!("Operation requires a dedicated pipeline")),
+        }
+    }
+
+    /// Whether the model was loaded in prompt-lookup decoding mode.
+    pub fn is_prompt_lookup(&self) -> bool {
+        self.speculative.prompt_lookup && self.speculative.draft_model_path.is_empty()
+    }
+
+    /// Whether this session can take concurrent requests through `submit`.
+    pub fn is_batched(&self) -> bool {
+        matches!(self.engine, Engine::Batched(_))
+    }
+
+    /// Whether a LoRA adapter with this name was loaded with the model.
+    pub fn has_adapter(&self, name: &str) -> bool {
+        self.adapters.iter().any(|adapter| adapter == name)
+    }
+
+    /// Choose the adapter for this session's generations; None runs the base
+    /// model. Switching only changes which weights are blended in, nothing is
+    /// reloaded.
+    pub fn set_adapter(&mut self, adapter: Option<(&str, f32)>) -> Result<()> {
+        if let Some((name, _)) = adapter {
+            if !self.has_adapter(name) {
+                return Err(anyhow::anyhow!("Adapter {} was not loaded with this model", name));
+            }
+        }
+        let adapter = adapter.map(|(name, alpha)| (name.to_string(), alpha));
+        if adapter == self.adapter {
+            return Ok(());
+        }
+
+        // KV kept from earlier turns was computed with the old weights. Chat
+        // mode starts over; a stored chat is replayed on its next turn
+        if let Engine::Pipeline(pipeline) = &mut self.engine {
+            pipeline.finish_chat()
+                .map_err(|e| anyhow::anyhow!("Failed to reset chat state: {}", e))?;
+            if self.in_chat_mode {
+                pipeline.start_chat()
+                    .map_err(|e| anyhow::anyhow!("Failed to restart chat: {}", e))?;
+            }
+            self.chat = None;
+        }
+        self.adapter = adapter;
+        Ok(())
+    }
+
+    /// Generation config carrying the session's adapter selection.
+    fn generation_config(&self, max_tokens: usize) -> Result<GenerationConfig> {
+        let mut config = GenerationConfig::new()?;
+        config.set_max_new_tokens(max_tokens)?;
+        if let Some((name, alpha)) = &self.adapter {
+            config.set_adapter(name, *alpha)?;
+        }
+        Ok(config)
+    }
+
+    /// Submit a request to the continuous-batching engine.
+    ///
+    /// Only needs shared access, so callers can hold a read lock on the session.
+    pub fn submit(&self, prompt: &str, config: GenerationConfig) -> Result<GenerationStream> {
+        match &self.engine {
+            Engine::Batched(engine) => engine.submit(prompt, config)
+                .map_err(|e| anyhow::anyhow!("Failed to submit request: {}", e)),
+            Engine::Pipeline(_) => Err(anyhow::anyhow!("Session was not loaded with continuous batching")),
+        }
+    }
+
+    /// KV reuse across requests; only the continuous-batching engine shares KV blocks.
+    pub fn kv_reuse_stats(&self) -> Option<KvReuseStats> {
+        match &self.engine {
+            Engine::Batched(engine) => Some(engine.kv_reuse_stats()),
+            Engine::Pipeline(_) => None,
+        }
+    }
+
+    /// KV block utilization of the continuous-batching engine; None for dedicated pipelines.
+    pub fn kv_cache_usage(&self) -> Option<KvCacheUsage> {
+        match &self.engine {
+            Engine::Batched(engine) => Some(engine.kv_cache_usage()),
+            Engine::Pipeline(_) => None,
+        }
+    }
+
+    /// Load and KV state of each continuous-batching replica; None for dedicated pipelines.
+    pub fn replica_stats(&self) -> Option<Vec<ReplicaStats>> {
+        match &self.engine {
+            Engine::Batched(engines) => Some(engines.replica_stats()),
+            Engine::Pipeline(_) => None,
+        }
+    }
+
+    /// Submit a conversation to the continuous-batching engine, formatted
+    /// with the model's chat template.
+    pub fn submit_chat(&self, messages: Vec<ChatMessage>, config: GenerationConfig) -> Result<GenerationStream> {
+        match &self.engine {
+            Engine::Batched(engine) => engine.submit_chat(messages, config)
+                .map_err(|e| anyhow::anyhow!("Failed to submit request: {}", e)),
+            Engine::Pipeline(_) => Err(anyhow::anyhow!("Session was not loaded with continuous batching")),
+        }
     }
 
     pub fn start_chat(&mut self) -> Result<()> {
-        self.pipeline.start_chat()
+        self.start_chat_with_system("")
+    }
+
+    /// Enter chat mode: the pipeline keeps history and KV cache between
+    /// generations. Starts a new anonymous chat.
+    pub fn start_chat_with_system(&mut self, system_message: &str) -> Result<()> {
+        self.pipeline_mut()?.start_chat_with_system(system_message)
             .map_err(|e| anyhow::anyhow!("Failed to start chat: {}", e))?;
         self.in_chat_mode = true;
+        self.chat = None;
         Ok(())
     }
 
     pub fn finish_chat(&mut self) -> Result<()> {
-        self.pipeline.finish_chat()
+        self.pipeline_mut()?.finish_chat()
             .map_err(|e| anyhow::anyhow!("Failed to finish chat: {}", e))?;
         self.in_chat_mode = false;
+        self.chat = None;
         Ok(())
     }
 
-    pub fn generate(&mut self, prompt: &str, max_tokens: usize) -> Result<String> {
-        let text = self.pipeline.generate(prompt, max_tokens)
-            .map_err(|e| anyhow::anyhow!("Generation failed: {}", e))?;
-        
-        self.context_tokens = self.pipeline.count_tokens(prompt) + self.pipeline.count_tokens(&text);
-        Ok(text)
+    /// Whether generations continue an anonymous chat-mode conversation.
+    pub fn in_anonymous_chat(&self) -> bool {
+        self.in_chat_mode && self.chat.is_none()
     }
 
-    pub fn generate_with_metrics(&mut self, prompt: &str, max_tokens: usize) -> Result<(String, InferenceMetrics)> {
-        let result = self.pipeline.generate_with_metrics(prompt, max_tokens)
-            .map_err(|e| anyhow::anyhow!("Generation failed: {}", e))?;
+    /// The stored chat `start_chat_turn` continues, if any.
+    pub fn active_chat(&self) -> Option<&str> {
+        self.chat.as_ref().map(|chat| chat.id.as_str())
+    }
 
-        let (throughput, _) = result.metrics.throughput();
-        let (ttft, _) = result.metrics.ttft();
-        let (duration, _) = result.metrics.generate_duration();
+    /// Switch to a stored chat.
+    ///
+    /// The chat runs in chat mode, so each turn prefills only its new message.
+    /// A chat resumed with earlier turns sends its whole history with the
+    /// first turn, which prefills it once; chat mode keeps it from then on.
+    pub fn resume_chat(&mut self, id: &str, history: Vec<ChatMessage>) -> Result<()> {
+        if history.iter().all(|m| m.role == "system") {
+            let system_message = history.iter()
+                .map(|m| m.content.as_str())
+                .collect::<Vec<_>>()
+                .join("\n");
+            self.start_chat_with_system(&system_message)?;
+            self.chat = Some(ChatState { id: id.to_string(), history: None });
+        } else {
+            self.start_chat()?;
+            self.chat = Some(ChatState { id: id.to_string(), history: Some(history) });
+        }
+        Ok(())
+    }
 
-        let num_input = result.metrics.num_input_tokens();
-        let num_output = result.metrics.num_generated_tokens();
+    /// Answer `user_message` in the active chat. Pass the task to
+    /// `finish_chat_turn` once the stream ends.
+    pub fn start_chat_turn(&mut self, user_message: &str, max_tokens: usize) -> Result<GenerationTask> {
+        let config = self.generation_config(max_tokens)?;
 
-        self.context_tokens = num_input + num_output;
+        let Engine::Pipeline(pipeline) = &self.engine else {
+            return Err(anyhow::anyhow!("Operation requires a dedicated pipeline"));
+        };
+        let chat = self.chat.as_mut()
+            .ok_or_else(|| anyhow::anyhow!("No active chat; call resume_chat first"))?;
 
-        let metrics = InferenceMetrics {
-            tokens_per_second: throughput,
-            time_to_first_token_ms: ttft,
-            num_input_tokens: num_input,
-            num_output_tokens: num_output,
-            total_time_ms: duration,
+        let Some(history) = chat.history.as_mut() else {
+            return pipeline.start_generation(user_message, &config)
+                .map_err(|e| anyhow::anyhow!("Failed to start generation: {}", e));
         };
+        history.push(ChatMessage {
+            role: "user".to_string(),
+            content: user_message.to_string(),
+        });
+        let task = pipeline.start_chat_generation(history, &config);
+        if task.is_err() {
+            history.pop();
+        }
+        task.map_err(|e| anyhow::anyhow!("Failed to start generation: {}", e))
+    }
+
+    /// Collect a task from `start_chat_turn`. After the first turn of a
+    /// resumed chat, chat mode holds the history and later turns send only
+    /// their own message.
+    pub fn finish_chat_turn(&mut self, task: GenerationTask) -> Result<(String, InferenceMetrics)> {
+        let finished = self.finish_generation(task);
+        let Some(chat) = self.chat.as_mut() else {
+            return finished;
+        };
+        let Some(history) = chat.history.as_mut() else {
+            return finished;
+        };
+
+        if finished.is_ok() {
+            chat.history = None;
+            return finished;
+        }
+        // A failed first turn leaves no trace: chat mode starts over and the
+        // history, without the unanswered message, is sent again next turn
+        history.pop();
+        let pipeline = self.pipeline_mut()?;
+        pipeline.finish_chat()
+            .and_then(|_| pipeline.start_chat())
+            .map_err(|e| anyhow::anyhow!("Failed to restart chat: {}", e))?;
+        finished
+    }
+
+    /// Blocking; must not be called from an async context, see `generate_with_metrics`.
+    pub fn generate(&mut self, prompt: &str, max_tokens: usize) -> Result<String> {
+        let (text, _) = self.generate_with_metrics(prompt, max_tokens)?;
+        Ok(text)
+    }
+
+    /// Generate to the end, blocking the calling thread. Must not be called
+    /// from an async context; a batched session waits on its engine in a way
+    /// that panics on a Tokio worker.
+    pub fn generate_with_metrics(&mut self, prompt: &str, max_tokens: usize) -> Result<(String, InferenceMetrics)> {
+        let config = self.generation_config(max_tokens)?;
+        let result = match &self.engine {
+            Engine::Pipeline(pipeline) => pipeline.generate_with_metrics_config(prompt, &config),
+            Engine::Batched(engines) => engines.pick(Some(prompt_affinity(prompt))).generate_blocking(prompt, config).map(|(result, _)| result),
+        }.map_err(|e| anyhow::anyhow!("Generation failed: {}", e))?;
+
+        let metrics = InferenceMetrics::from(&result.metrics);
+        self.context_tokens = metrics.num_input_tokens + metrics.num_output_tokens;
 
         Ok((result.text, metrics))
     }
 
+    /// Generate, passing text to `callback` as it is decoded; returning false
+    /// stops early with the partial text and its metrics. Blocking, and like
+    /// `generate_with_metrics` must not be called from an async context.
     pub fn generate_stream<F>(&mut self, prompt: &str, max_tokens: usize, mut callback: F) -> Result<(String, InferenceMetrics)> 
     where F: FnMut(&str) -> bool
     {
-        // Estimate prompt tokens if possible
-        let _prompt_tokens = self.pipeline.count_tokens(prompt);
-        
-        let result = self.pipeline.generate_stream(prompt, max_tokens, |token| {
-            callback(token)
-        })?;
+        let config = self.generation_config(max_tokens)?;
+        let result = match &self.engine {
+            Engine::Pipeline(pipeline) => pipeline.generate_stream_with_config(prompt, &config, |token| {
+                callback(token)
+            })?,
+            Engine::Batched(engine) => {
+                let (mut stream, stop) = engine.submit_stoppable(prompt, config)?;
 
-        let (throughput, _) = result.metrics.throughput();
-        let (ttft, _) = result.metrics.ttft();
-        let (duration, _) = result.metrics.generate_duration();
+                // A stopped request still finishes, with its text and metrics so far
+                let mut stopped = false;
+                loop {
+                    match stream.blocking_recv() {
+                        Some(GenerationEvent::Token(token)) => {
+                            if !stopped && !callback(&token) {
+                                stop.stop();
+                                stopped = true;
+                            }
+                        }
+                        Some(GenerationEvent::Finished { result, .. }) => break result,
+                        Some(GenerationEvent::Failed(e)) => return Err(anyhow::anyhow!("Generation failed: {}", e)),
+                        None => return Err(anyhow::anyhow!("Generation failed: engine dropped the request")),
+                    }
+                }
+            }
+        };
 
-        let num_input = result.metrics.num_input_tokens();
-        let num_output = result.metrics.num_generated_tokens();
+        let metrics = InferenceMetrics::from(&result.metrics);
 
         // Update session context size
         // Note: OpenVINO GenAI in chat mode handles history, 
         // but we want to know the total "active" context.
-        self.context_tokens = num_input + num_output;
+        self.context_tokens = metrics.num_input_tokens + metrics.num_output_tokens;
 
-        let metrics = InferenceMetrics {
-            tokens_per_second: throughput,
-            time_to_first_token_ms: ttft,
-            num_input_tokens: num_input,
-            num_output_tokens: num_output,
-            total_time_ms: duration,
+        Ok((result.text, metrics))
+    }
+
+    /// Generate completions for several prompts at once, results in prompt order.
+    ///
+    /// A dedicated pipeline runs them as one padded batch; the batching engine
+    /// admits them together so they share decode steps. Blocks until all are
+    /// done and must not be called from an async context; async callers use
+    /// `submit_batch` instead. `adapter`
+    /// overrides the session's adapter selection for this batch.
+    pub fn generate_batch(&self, prompts: &[&str], max_tokens: usize, stop: &[&str], adapter: Option<(&str, f32)>) -> Result<Vec<BatchCompletion>> {
+        let Engine::Pipeline(pipeline) = &self.engine else {
+            return self.submit_batch(prompts, max_tokens, stop, adapter)?
+                .into_iter()
+                .map(|stream| futures::executor::block_on(BatchCompletion::collect(stream)))
+                .collect();
+        };
+
+        let batch = pipeline.generate_batch(prompts, &self.batch_config(max_tokens, stop, adapter)?)
+            .map_err(|e| anyhow::anyhow!("Generation failed: {}", e))?;
+        let batch_metrics = InferenceMetrics::from(&batch.metrics);
+
+        Ok(batch.sequences.into_iter().map(|seq| {
+            let metrics = InferenceMetrics {
+                num_input_tokens: seq.num_input_tokens,
+                num_output_tokens: seq.num_generated_tokens,
+                ..batch_metrics
+            };
+            // Batched results carry no finish reason; only the cap ends a sequence without a stop
+            let finish_reason = if seq.num_generated_tokens >= max_tokens { "length" } else { "stop" };
+            BatchCompletion {
+                text: seq.text,
+                metrics,
+                finish_reason: finish_reason.to_string(),
+            }
+        }).collect())
+    }
+
+    /// Submit several prompts to the batching engine at once, streams in prompt
+    /// order. The engine admits them together so they share decode steps;
+    /// await each with `BatchCompletion::collect`.
+    pub fn submit_batch(&self, prompts: &[&str], max_tokens: usize, stop: &[&str], adapter: Option<(&str, f32)>) -> Result<Vec<GenerationStream>> {
+        let Engine::Batched(engine) = &self.engine else {
+            return Err(anyhow::anyhow!("Session was not loaded with continuous batching"));
         };
 
+        prompts.iter()
+            .map(|prompt| {
+                let config = self.batch_config(max_tokens, stop, adapter)?;
+                engine.submit(prompt, config)
+                    .map_err(|e| anyhow::anyhow!("Failed to submit request: {}", e))
+            })
+            .collect()
+    }
+
+    fn batch_config(&self, max_tokens: usize, stop: &[&str], adapter: Option<(&str, f32)>) -> Result<GenerationConfig> {
+        if let Some((name, _)) = adapter.filter(|(name, _)| !self.has_adapter(name)) {
+            return Err(anyhow::anyhow!("Adapter {} was not loaded with this model", name));
+        }
+        let mut config = self.generation_config(max_tokens)?;
+        if let Some((name, alpha)) = adapter {
+            config.set_adapter(name, alpha)?;
+        }
+        if !stop.is_empty() {
+            config.set_stop_strings(stop)?;
+        }
+        Ok(config)
+    }
+
+    /// Start a generation on the bridge's worker thread and return it as a stream,
+    /// so async callers don't block on inference. Pass the task to
+    /// `finish_generation` once the stream ends.
+    pub fn start_generation(&self, prompt: &str, max_tokens: usize) -> Result<GenerationTask> {
+        let config = self.generation_config(max_tokens)?;
+
+        self.pipeline()?.start_generation(prompt, &config)
+            .map_err(|e| anyhow::anyhow!("Failed to start generation: {}", e))
+    }
+
+    /// Collect the result of a task from `start_generation`.
+    pub fn finish_generation(&mut self, task: GenerationTask) -> Result<(String, InferenceMetrics)> {
+        let result = task.join()
+            .map_err(|e| anyhow::anyhow!("Generation failed: {}", e))?;
+
+        let metrics = InferenceMetrics::from(&result.metrics);
+        self.context_tokens = metrics.num_input_tokens + metrics.num_output_tokens;
+
         Ok((result.text, metrics))
     }
 
     pub fn get_context_tokens(&self) -> usize {
         self.context_tokens
     }
+
+    /// Count tokens for several texts in one tokenizer call.
+    pub fn count_tokens_batch(&self, texts: &[&str]) -> Result<Vec<usize>> {
+        self.pipeline()?.count_tokens_batch(texts)
+            .map_err(|e| anyhow::anyhow!("Tokenization failed: {}", e))
+    }
 }
@@ -5,10 +5,12 @@ pub mod hardware;
 pub mod config;
 pub mod db;
 pub mod genai_bridge;
+pub mod scheduler;
 
-pub use api::{create_router, AppState};
+pub use api::{create_router, AppState, ConversationStore};
 pub use config::Config;
 pub use db::Database;
-pub use inference::{InferenceSession, InferenceMetrics};
+pub use scheduler::{ModelLoader, RequestScheduler, ResidencyManager};
+pub use inference::{InferenceSession, InferenceMetrics, EmbeddingSession};
 pub use model_manager::{Registry, Downloader, ModelInfo, HuggingFaceModel, ModelData, FileInfo};
 pub use hardware::{detect_devices, select_best_device, detect_system_resources, validate_model_load, DeviceInfo, DeviceType, SystemResources, GpuResource, ResourceMode, ValidationResult};
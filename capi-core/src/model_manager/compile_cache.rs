@@ -0,0 +1,181 @@
+use anyhow::Result;
+use std::fs;
+use std::path::{Path, PathBuf};
+use crate::config::Config;
+
+const LAST_USED_FILE: &str = ".last_used";
+
+/// Managed directory of OpenVINO compiled-model blobs under `data_dir`.
+///
+/// Each entry is keyed by model fingerprint, device and OpenVINO version and
+/// passed to the pipeline as `CACHE_DIR`. Entries are evicted least recently
+/// used first once the total size exceeds the configured cap.
+pub struct CompileCache {
+    root: PathBuf,
+    max_bytes: u64,
+}
+
+#[derive(Debug, Clone)]
+pub struct CacheEntry {
+    pub dir: PathBuf,
+    /// True when the entry already held compiled blobs before this load
+    pub warm: bool,
+}
+
+impl CompileCache {
+    pub fn new(config: &Config) -> Self {
+        Self {
+            root: config.compile_cache_dir(),
+            max_bytes: config.compile_cache_max_gb * 1_000_000_000,
+        }
+    }
+
+    pub fn entry_dir(&self, model_path: &Path, device: &str) -> Result<PathBuf> {
+        let ov_version = crate::inference::genai::openvino_version();
+        let key = format!(
+            "{:016x}-{}-{}",
+            model_fingerprint(model_path)?,
+            sanitize(&device.to_uppercase()),
+            sanitize(&ov_version),
+        );
+        Ok(self.root.join(key))
+    }
+
+    pub fn is_warm(&self, model_path: &Path, device: &str) -> bool {
+        self.entry_dir(model_path, device)
+            .map(|dir| has_blobs(&dir))
+            .unwrap_or(false)
+    }
+
+    /// Create (or reuse) the entry for a model and mark it as just used.
+    pub fn prepare(&self, model_path: &Path, device: &str) -> Result<CacheEntry> {
+        let dir = self.entry_dir(model_path, device)?;
+        let warm = has_blobs(&dir);
+
+        fs::create_dir_all(&dir)?;
+        fs::write(dir.join(LAST_USED_FILE), now_secs().to_string())?;
+
+        Ok(CacheEntry { dir, warm })
+    }
+
+    /// Remove least recently used entries until the cache fits its cap.
+    /// `keep` is never evicted. Returns the removed entry directories.
+    pub fn evict(&self, keep: &Path) -> Result<Vec<PathBuf>> {
+        let mut entries: Vec<(PathBuf, u64, i64)> = Vec::new();
+        let mut total: u64 = 0;
+
+        if let Ok(read_dir) = fs::read_dir(&self.root) {
+            for entry in read_dir.flatten() {
+                let path = entry.path();
+                if !path.is_dir() {
+                    continue;
+                }
+                let size = dir_size(&path);
+                let last_used = fs::read_to_string(path.join(LAST_USED_FILE))
+                    .ok()
+                    .and_then(|s| s.trim().parse::<i64>().ok())
+                    .unwrap_or(0);
+                total += size;
+                entries.push((path, size, last_used));
+            }
+        }
+
+        entries.sort_by_key(|(_, _, last_used)| *last_used);
+
+        let mut removed = Vec::new();
+        for (path, size, _) in entries {
+            if total <= self.max_bytes {
+                break;
+            }
+            if path == keep {
+                continue;
+            }
+            if fs::remove_dir_all(&path).is_ok() {
+                total = total.saturating_sub(size);
+                removed.push(path);
+            }
+        }
+
+        Ok(removed)
+    }
+}
+
+/// Cheap identity for a model: file names, sizes and modification times.
+/// Hashing multi-GB weights on every load would cost more than it saves.
+fn model_fingerprint(model_path: &Path) -> Result<u64> {
+    let mut files: Vec<PathBuf> = if model_path.is_dir() {
+        fs::read_dir(model_path)?
+            .filter_map(|e| e.ok())
+            .map(|e| e.path())
+            .filter(|p| p.is_file())
+            .collect()
+    } else {
+        vec![model_path.to_path_buf()]
+    };
+    files.sort();
+
+    let mut hash = Fnv64::new();
+    for file in files {
+        let meta = fs::metadata(&file)?;
+        let mtime = meta.modified().ok()
+            .and_then(|t| t.duration_since(std::time::UNIX_EPOCH).ok())
+            .map(|d| d.as_secs())
+            .unwrap_or(0);
+
+        hash.write(file.to_string_lossy().as_bytes());
+        hash.write(&meta.len().to_le_bytes());
+        hash.write(&mtime.to_le_bytes());
+    }
+    Ok(hash.finish())
+}
+
+// FNV-1a; stable across Rust releases, unlike DefaultHasher
+struct Fnv64(u64);
+
+impl Fnv64 {
+    fn new() -> Self {
+        Self(0xcbf29ce484222325)
+    }
+
+    fn write(&mut self, bytes: &[u8]) {
+        for b in bytes {
+            self.0 ^= *b as u64;
+            self.0 = self.0.wrapping_mul(0x100000001b3);
+        }
+    }
+
+    fn finish(&self) -> u64 {
+        self.0
+    }
+}
+
+fn has_blobs(dir: &Path) -> bool {
+    fs::read_dir(dir)
+        .map(|entries| entries.flatten().any(|e| {
+            e.path().extension().map_or(false, |ext| ext == "blob")
+        }))
+        .unwrap_or(false)
+}
+
+fn dir_size(dir: &Path) -> u64 {
+    fs::read_dir(dir)
+        .map(|entries| entries.flatten()
+            .filter_map(|e| e.metadata().ok())
+            .filter(|m| m.is_file())
+            .map(|m| m.len())
+            .sum())
+        .unwrap_or(0)
+}
+
+fn sanitize(s: &str) -> String {
+    s.chars()
+        .map(|c| if c.is_ascii_alphanumeric() || c == '.' { c } else { '_' })
+        .collect()
+}
+
+fn now_secs() -> i64 {
+    std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .unwrap_or_default()
+        .as_secs() as i64
+}
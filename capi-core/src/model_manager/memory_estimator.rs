@@ -1,9 +1,16 @@
 use anyhow::Result;
+use std::path::Path;
+
+/// Bytes per GB of a configured memory or KV budget. OpenVINO sizes
+/// `cache_size` in GiB, so every budget uses the same unit.
+pub const GIB: u64 = 1024 * 1024 * 1024;
 
 #[derive(Debug, Clone)]
 pub struct MemoryEstimate {
     pub file_size_bytes: u64,
     pub estimated_runtime_bytes: u64,
+    /// KV cache share of the runtime estimate; 0 when the model shape is unknown
+    pub kv_cache_bytes: u64,
 }
 
 pub fn estimate_memory_from_file_size(file_size_bytes: u64) -> Result<MemoryEstimate> {
@@ -14,5 +21,115 @@ pub fn estimate_memory_from_file_size(file_size_bytes: u64) -> Result<MemoryEsti
     Ok(MemoryEstimate {
         file_size_bytes,
         estimated_runtime_bytes,
+        kv_cache_bytes: 0,
     })
 }
+
+/// Estimate runtime memory with the KV cache sized for `context_tokens` at
+/// `kv_bytes_per_token`, instead of folding it into the 1.5x ballpark.
+pub fn estimate_memory(file_size_bytes: u64, kv_bytes_per_token: Option<u64>, context_tokens: u64) -> Result<MemoryEstimate> {
+    let Some(per_token) = kv_bytes_per_token else {
+        return estimate_memory_from_file_size(file_size_bytes);
+    };
+
+    estimate_memory_with_kv_cache(file_size_bytes, per_token * context_tokens)
+}
+
+/// Estimate runtime memory with a KV cache of fixed size, e.g. a configured budget.
+pub fn estimate_memory_with_kv_cache(file_size_bytes: u64, kv_cache_bytes: u64) -> Result<MemoryEstimate> {
+    // Weights plus compiled-model and activation overhead
+    let weights_bytes = (file_size_bytes as f64 * 1.2) as u64;
+
+    Ok(MemoryEstimate {
+        file_size_bytes,
+        estimated_runtime_bytes: weights_bytes + kv_cache_bytes,
+        kv_cache_bytes,
+    })
+}
+
+/// How KV cache entries are stored.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum KvCachePrecision {
+    /// Whatever the device plugin picks
+    Auto,
+    F16,
+    U8,
+    U4,
+}
+
+impl KvCachePrecision {
+    pub fn parse(value: &str) -> Result<Self> {
+        match value.to_lowercase().as_str() {
+            "auto" => Ok(Self::Auto),
+            "f16" => Ok(Self::F16),
+            "u8" => Ok(Self::U8),
+            "u4" => Ok(Self::U4),
+            other => Err(anyhow::anyhow!("Unknown KV cache precision: {} (use auto, f16, u8 or u4)", other)),
+        }
+    }
+
+    pub fn as_str(&self) -> &'static str {
+        match self {
+            Self::Auto => "auto",
+            Self::F16 => "f16",
+            Self::U8 => "u8",
+            Self::U4 => "u4",
+        }
+    }
+
+    /// Storage bits per element; `Auto` is counted as f16 so estimates stay conservative.
+    fn bits(&self) -> u64 {
+        match self {
+            Self::Auto | Self::F16 => 16,
+            Self::U8 => 8,
+            Self::U4 => 4,
+        }
+    }
+
+    fn is_quantized(&self) -> bool {
+        matches!(self, Self::U8 | Self::U4)
+    }
+}
+
+/// KV-relevant shape of a transformer, from its config.json.
+#[derive(Debug, Clone, Copy)]
+pub struct KvCacheLayout {
+    pub num_layers: u64,
+    pub num_kv_heads: u64,
+    pub head_dim: u64,
+}
+
+impl KvCacheLayout {
+    /// Read the layout from the config.json next to (or inside) `model_path`.
+    /// None for GGUF files and exports without a usable config.
+    pub fn from_model_dir(model_path: &Path) -> Option<Self> {
+        let dir = if model_path.is_dir() { model_path } else { model_path.parent()? };
+        let config: serde_json::Value = serde_json::from_str(&std::fs::read_to_string(dir.join("config.json")).ok()?).ok()?;
+        Self::from_config(&config)
+    }
+
+    pub fn from_config(config: &serde_json::Value) -> Option<Self> {
+        let field = |name: &str| config.get(name).and_then(|v| v.as_u64());
+
+        let num_layers = field("num_hidden_layers")?;
+        let num_heads = field("num_attention_heads")?;
+        // Grouped-query attention caches fewer heads than it attends with
+        let num_kv_heads = field("num_key_value_heads").unwrap_or(num_heads);
+        let head_dim = field("head_dim").or_else(|| Some(field("hidden_size")? / num_heads.max(1)))?;
+
+        Some(Self { num_layers, num_kv_heads, head_dim })
+    }
+
+    /// Bytes one token occupies in the KV cache, keys and values over all layers.
+    /// Quantized caches also store a scale and zero point (f32 each) per group.
+    pub fn bytes_per_token(&self, precision: KvCachePrecision, group_size: Option<usize>) -> u64 {
+        let elements = 2 * self.num_layers * self.num_kv_heads * self.head_dim;
+        let mut bytes = elements * precision.bits() / 8;
+
+        if precision.is_quantized() {
+            let group_size = group_size.map(|g| g as u64).unwrap_or(self.head_dim).max(1);
+            bytes += elements.div_ceil(group_size) * 8;
+        }
+        bytes
+    }
+}
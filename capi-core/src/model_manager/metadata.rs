@@ -1,5 +1,7 @@
 // unused import removed
 use serde::{Deserialize, Serialize};
+use std::path::Path;
+use crate::db::models::{MODEL_TYPE_EMBEDDING, MODEL_TYPE_LLM};
 
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -12,4 +14,24 @@ pub struct ModelMetadata {
     pub max_position_embeddings: Option<u64>,
 }
 
+/// Files that sentence-transformers (and optimum exports of its models) write
+/// next to the weights; the pooling config is what makes a model an embedder.
+const SENTENCE_TRANSFORMERS_FILES: &[&str] = &[
+    "modules.json",
+    "1_Pooling/config.json",
+    "config_sentence_transformers.json",
+    "sentence_bert_config.json",
+];
+
+/// Whether an OpenVINO model directory holds an LLM or an embedding model.
+/// Embedding models ship a pooling config or other sentence-transformers
+/// files; architecture names alone do not tell an encoder from a decoder.
+pub fn detect_model_type(model_path: &Path) -> &'static str {
+    let dir = if model_path.is_dir() { model_path } else { model_path.parent().unwrap_or(model_path) };
+
+    let is_embedding = SENTENCE_TRANSFORMERS_FILES.iter().any(|file| dir.join(file).is_file());
+
+    if is_embedding { MODEL_TYPE_EMBEDDING } else { MODEL_TYPE_LLM }
+}
+
 // parse_config removed as unused
@@ -3,9 +3,11 @@ mod downloader;
 mod metadata;
 mod memory_estimator;
 mod model_lock;
+mod compile_cache;
 
 pub use registry::Registry;
 pub use downloader::{Downloader, ModelInfo, HuggingFaceModel, ModelData, FileInfo};
-pub use metadata::ModelMetadata;
-pub use memory_estimator::{MemoryEstimate, estimate_memory_from_file_size};
+pub use metadata::{ModelMetadata, detect_model_type};
+pub use memory_estimator::{MemoryEstimate, estimate_memory_from_file_size, estimate_memory, estimate_memory_with_kv_cache, KvCachePrecision, KvCacheLayout, GIB};
 pub use model_lock::ModelLock;
+pub use compile_cache::{CompileCache, CacheEntry};
@@ -1,6 +1,9 @@
-use crate::db::{Database, ModelRecord, models};
+use crate::config::{Config, KvCacheSettings};
+use crate::db::{AdapterRecord, Database, ModelRecord, adapters, models};
+use super::{GIB, KvCacheLayout, KvCachePrecision, estimate_memory, estimate_memory_from_file_size, estimate_memory_with_kv_cache};
+use crate::inference::genai::{LoraAdapter, SpeculativeConfig};
 use anyhow::Result;
-use std::path::PathBuf;
+use std::path::{Path, PathBuf};
 use std::sync::{Arc, RwLock};
 
 pub struct Registry {
@@ -29,7 +32,46 @@ impl Registry {
     }
 
     pub fn remove_model(&self, id: &str) -> Result<()> {
-        self.db.with_connection(|conn| models::delete_model(conn, id))
+        self.db.with_connection(|conn| {
+            adapters::delete_adapters_for_model(conn, id)?;
+            models::delete_model(conn, id)
+        })
+    }
+
+    /// Register a LoRA adapter under its base model.
+    pub fn add_adapter(&self, adapter: AdapterRecord) -> Result<()> {
+        let base = self.get_model(&adapter.base_model_id)?
+            .ok_or_else(|| anyhow::anyhow!("Base model not found: {}", adapter.base_model_id))?;
+        if base.is_embedding() {
+            return Err(anyhow::anyhow!("{} is an embedding model; adapters need an LLM", base.id));
+        }
+        if self.get_model(&adapter.id)?.is_some() {
+            return Err(anyhow::anyhow!("A model with id {} already exists", adapter.id));
+        }
+        self.db.with_connection(|conn| adapters::insert_adapter(conn, &adapter))
+    }
+
+    pub fn list_adapters(&self, base_model_id: &str) -> Result<Vec<AdapterRecord>> {
+        self.db.with_connection(|conn| adapters::list_adapters(conn, base_model_id))
+    }
+
+    pub fn get_adapter(&self, id: &str) -> Result<Option<AdapterRecord>> {
+        self.db.with_connection(|conn| adapters::get_adapter(conn, id))
+    }
+
+    pub fn remove_adapter(&self, id: &str) -> Result<()> {
+        self.db.with_connection(|conn| adapters::delete_adapter(conn, id))
+    }
+
+    /// Adapters to register when loading a base model, named by adapter id.
+    pub fn lora_adapters_for(&self, model: &ModelRecord) -> Result<Vec<LoraAdapter>> {
+        Ok(self.list_adapters(&model.id)?
+            .into_iter()
+            .map(|adapter| LoraAdapter {
+                name: adapter.id,
+                path: adapter.path,
+            })
+            .collect())
     }
 
     pub fn set_active_model(&self, id: String) -> Result<()> {
@@ -62,4 +104,130 @@ impl Registry {
         }
         Ok(None)
     }
+
+    pub fn set_prompt_lookup(&self, id: &str, enabled: bool) -> Result<()> {
+        if self.get_model(id)?.is_none() {
+            return Err(anyhow::anyhow!("Model not found: {}", id));
+        }
+        self.db.with_connection(|conn| models::set_prompt_lookup(conn, id, enabled))
+    }
+
+    pub fn set_model_type(&self, id: &str, model_type: &str) -> Result<()> {
+        if model_type != models::MODEL_TYPE_LLM && model_type != models::MODEL_TYPE_EMBEDDING {
+            return Err(anyhow::anyhow!("Unknown model type: {}", model_type));
+        }
+        if self.get_model(id)?.is_none() {
+            return Err(anyhow::anyhow!("Model not found: {}", id));
+        }
+        self.db.with_connection(|conn| models::set_model_type(conn, id, model_type))
+    }
+
+    /// Override the KV cache precision for a model; None goes back to the config default.
+    pub fn set_kv_cache_precision(&self, id: &str, precision: Option<&str>) -> Result<()> {
+        let precision = precision.map(KvCachePrecision::parse).transpose()?;
+        if self.get_model(id)?.is_none() {
+            return Err(anyhow::anyhow!("Model not found: {}", id));
+        }
+        self.db.with_connection(|conn| models::set_kv_cache_precision(conn, id, precision.map(|p| p.as_str())))
+    }
+
+    /// KV cache settings for a model: the config section with the model's precision,
+    /// budget and context overrides.
+    pub fn kv_cache_settings_for(&self, config: &Config, model: &ModelRecord) -> KvCacheSettings {
+        KvCacheSettings {
+            precision: model.kv_cache_precision.clone().unwrap_or_else(|| config.kv_cache.precision.clone()),
+            budget_gb: config.kv_cache.model_budgets_gb.get(&model.id).copied().or(config.kv_cache.budget_gb),
+            context_length: Some(self.context_length_for(config, model)),
+            ..config.kv_cache.clone()
+        }
+    }
+
+    /// Context length a model is loaded and estimated with: its override, else the config default.
+    pub fn context_length_for(&self, config: &Config, model: &ModelRecord) -> u64 {
+        model.context_override
+            .map(|c| c.max(0) as u64)
+            .unwrap_or(config.default_context_length)
+    }
+
+    /// Continuous-batching replicas to serve a model with.
+    pub fn replicas_for(&self, config: &Config, model: &ModelRecord) -> usize {
+        config.scheduler.model_replicas.get(&model.id).copied()
+            .unwrap_or(config.scheduler.replicas)
+            .max(1)
+    }
+
+    /// Replicas that fit in `available_bytes`: the configured count, reduced
+    /// one at a time while their weight copies and KV cache would not fit.
+    /// Always at least one.
+    pub fn replicas_within(&self, config: &Config, model: &ModelRecord, available_bytes: u64) -> usize {
+        let configured = self.replicas_for(config, model);
+        (2..=configured).rev()
+            .find(|&replicas| self.replica_memory_bytes(config, model, replicas) <= available_bytes)
+            .unwrap_or(1)
+    }
+
+    /// Memory a loaded model is expected to hold: its registered estimate, or
+    /// weights plus the configured KV cache budget when one applies. Each
+    /// replica is a compiled pipeline holding its own copy of the weights.
+    pub fn resident_memory_bytes(&self, config: &Config, model: &ModelRecord) -> u64 {
+        self.replica_memory_bytes(config, model, self.replicas_for(config, model))
+    }
+
+    /// `resident_memory_bytes` for an LLM loaded with `replicas` replicas.
+    pub fn replica_memory_bytes(&self, config: &Config, model: &ModelRecord, replicas: usize) -> u64 {
+        let file_size = model.size_bytes.unwrap_or(0).max(0) as u64;
+        let registered = || model.estimated_memory_bytes.map(|bytes| bytes.max(0) as u64)
+            .unwrap_or_else(|| estimate_memory_from_file_size(file_size).map(|e| e.estimated_runtime_bytes).unwrap_or(file_size));
+        if model.is_embedding() {
+            return registered();
+        }
+
+        let replicas = replicas.max(1) as u64;
+        match self.kv_cache_settings_for(config, model).budget_gb {
+            // Replicas split the budget in whole GiB; loads reject a budget below one each
+            Some(budget_gb) => {
+                let kv_bytes = (budget_gb as u64 / replicas) * replicas * GIB;
+                let weights = estimate_memory_with_kv_cache(file_size, 0)
+                    .map(|e| e.estimated_runtime_bytes)
+                    .unwrap_or(file_size);
+                weights * replicas + kv_bytes
+            }
+            None => registered() * replicas,
+        }
+    }
+
+    /// Estimated memory of one live conversation on an LLM: a pipeline of its
+    /// own, i.e. a compiled copy of the weights, plus a KV cache holding up to
+    /// `context_tokens`.
+    pub fn conversation_memory_bytes(&self, config: &Config, model: &ModelRecord, context_tokens: usize) -> u64 {
+        let file_size = model.size_bytes.unwrap_or(0).max(0) as u64;
+        let kv_cache = self.kv_cache_settings_for(config, model);
+        let kv_bytes_per_token = KvCachePrecision::parse(&kv_cache.precision).ok()
+            .and_then(|precision| KvCacheLayout::from_model_dir(Path::new(&model.path))
+                .map(|layout| layout.bytes_per_token(precision, kv_cache.group_size)));
+        estimate_memory(file_size, kv_bytes_per_token, context_tokens as u64)
+            .map(|e| e.estimated_runtime_bytes)
+            .unwrap_or(file_size)
+    }
+
+    /// Speculative decoding for a model: the draft model paired with it in the
+    /// `speculative` config section, else prompt lookup if enabled on the model.
+    pub fn speculative_config_for(&self, config: &Config, model: &ModelRecord, device: &str) -> Result<SpeculativeConfig> {
+        let settings = &config.speculative;
+        let mut speculative = SpeculativeConfig {
+            prompt_lookup: model.prompt_lookup,
+            num_assistant_tokens: settings.num_assistant_tokens,
+            max_ngram_size: settings.max_ngram_size,
+            ..Default::default()
+        };
+
+        if let Some(draft_id) = settings.draft_models.get(&model.id) {
+            let draft = self.get_model(draft_id)?
+                .ok_or_else(|| anyhow::anyhow!("Draft model not found: {}", draft_id))?;
+            speculative.draft_model_path = draft.path;
+            speculative.draft_device = settings.draft_device.clone().unwrap_or_else(|| device.to_string());
+        }
+
+        Ok(speculative)
+    }
 }
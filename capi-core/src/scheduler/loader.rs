@@ -0,0 +1,118 @@
+use futures::future::{BoxFuture, FutureExt, Shared};
+use std::collections::HashMap;
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+use tokio::sync::{Mutex, RwLock};
+
+type LoadFuture<T> = Shared<BoxFuture<'static, Result<T, String>>>;
+
+struct InFlight<T> {
+    future: LoadFuture<T>,
+    started: Instant,
+}
+
+/// A model load that has not finished yet.
+#[derive(Debug, Clone)]
+pub struct LoadingModel {
+    pub model: String,
+    pub elapsed: Duration,
+}
+
+/// Single-flight loads into a shared session map.
+///
+/// The first request for a cold model starts the load on a blocking thread;
+/// later requests for the same model await the same future. The map itself
+/// is only locked to look up and insert, so loaded models keep serving while
+/// another one compiles.
+pub struct ModelLoader<T> {
+    loads: Arc<Mutex<HashMap<String, InFlight<T>>>>,
+}
+
+impl<T> Clone for ModelLoader<T> {
+    fn clone(&self) -> Self {
+        Self { loads: Arc::clone(&self.loads) }
+    }
+}
+
+impl<T> Default for ModelLoader<T> {
+    fn default() -> Self {
+        Self { loads: Arc::new(Mutex::new(HashMap::new())) }
+    }
+}
+
+impl<T: Clone + Send + Sync + 'static> ModelLoader<T> {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Return the cached entry for `model_id`, or run `load` once and cache
+    /// its result. A failed load is reported to every waiter and not cached,
+    /// so the next request tries again.
+    pub async fn get_or_load<F>(
+        &self,
+        cache: &Arc<RwLock<HashMap<String, T>>>,
+        model_id: &str,
+        load: F,
+    ) -> anyhow::Result<T>
+    where
+        F: FnOnce() -> anyhow::Result<T> + Send + 'static,
+    {
+        if let Some(cached) = cache.read().await.get(model_id) {
+            return Ok(cached.clone());
+        }
+
+        let future = {
+            let mut loads = self.loads.lock().await;
+            // A load may have finished since the first check; it inserts into
+            // the cache before leaving `loads`, so one of the two has it
+            if let Some(cached) = cache.read().await.get(model_id) {
+                return Ok(cached.clone());
+            }
+            loads.entry(model_id.to_string())
+                .or_insert_with(|| InFlight {
+                    future: self.start(Arc::clone(cache), model_id.to_string(), load),
+                    started: Instant::now(),
+                })
+                .future
+                .clone()
+        };
+
+        future.await.map_err(|e| anyhow::anyhow!(e))
+    }
+
+    /// Spawn the load so it completes and lands in the cache even if every
+    /// waiting request goes away.
+    fn start<F>(&self, cache: Arc<RwLock<HashMap<String, T>>>, model_id: String, load: F) -> LoadFuture<T>
+    where
+        F: FnOnce() -> anyhow::Result<T> + Send + 'static,
+    {
+        let loads = Arc::clone(&self.loads);
+        let task = tokio::spawn(async move {
+            let result = match tokio::task::spawn_blocking(load).await {
+                Ok(Ok(value)) => Ok(value),
+                Ok(Err(e)) => Err(e.to_string()),
+                Err(e) => Err(format!("Loading {} panicked: {}", model_id, e)),
+            };
+            if let Ok(value) = &result {
+                cache.write().await.insert(model_id.clone(), value.clone());
+            }
+            loads.lock().await.remove(&model_id);
+            result
+        });
+
+        async move {
+            task.await.map_err(|e| e.to_string())?
+        }.boxed().shared()
+    }
+
+    /// Models currently being loaded, oldest first.
+    pub async fn loading(&self) -> Vec<LoadingModel> {
+        let loads = self.loads.lock().await;
+        let mut loading: Vec<_> = loads.iter().map(|(model, load)| LoadingModel {
+            model: model.clone(),
+            elapsed: load.started.elapsed(),
+        }).collect();
+        loading.sort_by(|a, b| b.elapsed.cmp(&a.elapsed));
+        loading
+    }
+}
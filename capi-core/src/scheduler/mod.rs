@@ -0,0 +1,15 @@
+//! Request scheduling in front of the inference engines.
+//!
+//! Every model gets a bounded FIFO queue and a cap on sequences in flight.
+//! Requests beyond the queue depth are turned away at once with a retry hint,
+//! so overload shows up as fast rejections rather than piled-up tasks.
+//! Cold models are loaded once however many requests arrive for them, and
+//! idle ones are unloaded to keep the loaded set within a memory budget.
+
+mod loader;
+mod queue;
+mod residency;
+
+pub use loader::{LoadingModel, ModelLoader};
+pub use queue::{QueueFull, QueuePermit, QueueStats, RequestScheduler};
+pub use residency::{Eviction, EvictionReason, ResidencyManager, ResidencyStats, ResidentModel};
@@ -0,0 +1,173 @@
+use crate::config::QueueSettings;
+use serde::Serialize;
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+use thiserror::Error;
+use tokio::sync::{OwnedSemaphorePermit, Semaphore};
+
+/// A model's queue was full when the request arrived.
+#[derive(Debug, Clone, Error)]
+#[error("Too many requests queued for {model} ({queued} waiting); retry in {retry_after_secs}s")]
+pub struct QueueFull {
+    pub model: String,
+    pub queued: usize,
+    /// Estimated time until a place frees up
+    pub retry_after_secs: u64,
+}
+
+/// Queue state for one model.
+#[derive(Debug, Clone, Serialize)]
+pub struct QueueStats {
+    pub model: String,
+    pub in_flight: usize,
+    pub waiting: usize,
+    pub max_in_flight: usize,
+    pub admitted: u64,
+    pub rejected: u64,
+    /// Moving average of how long a request holds its slots
+    pub avg_service_ms: u64,
+}
+
+struct ModelQueue {
+    /// One permit per sequence in flight; tokio hands them out in FIFO order
+    slots: Arc<Semaphore>,
+    max_in_flight: usize,
+    waiting: AtomicUsize,
+    avg_service_ms: AtomicU64,
+    admitted: AtomicU64,
+    rejected: AtomicU64,
+}
+
+impl ModelQueue {
+    fn new(max_in_flight: usize) -> Self {
+        Self {
+            slots: Arc::new(Semaphore::new(max_in_flight)),
+            max_in_flight,
+            waiting: AtomicUsize::new(0),
+            avg_service_ms: AtomicU64::new(0),
+            admitted: AtomicU64::new(0),
+            rejected: AtomicU64::new(0),
+        }
+    }
+
+    /// Rough wait for the back of the queue: one service time per wave of
+    /// `max_in_flight` requests ahead of it.
+    fn retry_after_secs(&self, waiting: usize) -> u64 {
+        let waves = waiting / self.max_in_flight + 1;
+        let wait_ms = self.avg_service_ms.load(Ordering::Relaxed) * waves as u64;
+        (wait_ms / 1000).clamp(1, 60)
+    }
+
+    fn record_service(&self, elapsed: Duration) {
+        let sample = elapsed.as_millis() as u64;
+        let _ = self.avg_service_ms.fetch_update(Ordering::Relaxed, Ordering::Relaxed, |avg| {
+            Some(if avg == 0 { sample } else { (avg * 7 + sample) / 8 })
+        });
+    }
+}
+
+/// Slots held by an admitted request; released when dropped.
+pub struct QueuePermit {
+    _permit: OwnedSemaphorePermit,
+    queue: Arc<ModelQueue>,
+    queue_time: Duration,
+    admitted_at: Instant,
+}
+
+impl QueuePermit {
+    /// How long the request waited in the queue.
+    pub fn queue_time(&self) -> Duration {
+        self.queue_time
+    }
+}
+
+impl Drop for QueuePermit {
+    fn drop(&mut self) {
+        self.queue.record_service(self.admitted_at.elapsed());
+    }
+}
+
+/// Leaves the queue's waiting count when an acquire finishes or is abandoned.
+struct Waiting<'a>(&'a AtomicUsize);
+
+impl Drop for Waiting<'_> {
+    fn drop(&mut self) {
+        self.0.fetch_sub(1, Ordering::SeqCst);
+    }
+}
+
+/// Per-model bounded queues with a cap on in-flight sequences.
+#[derive(Clone)]
+pub struct RequestScheduler {
+    settings: QueueSettings,
+    queues: Arc<Mutex<HashMap<String, Arc<ModelQueue>>>>,
+}
+
+impl RequestScheduler {
+    pub fn new(settings: QueueSettings) -> Self {
+        Self {
+            settings,
+            queues: Arc::new(Mutex::new(HashMap::new())),
+        }
+    }
+
+    fn queue(&self, model: &str) -> Arc<ModelQueue> {
+        let mut queues = self.queues.lock().unwrap();
+        let queue = queues.entry(model.to_string())
+            .or_insert_with(|| Arc::new(ModelQueue::new(self.settings.max_in_flight.max(1))));
+        Arc::clone(queue)
+    }
+
+    /// Wait for `sequences` slots on `model`, in arrival order. Fails at once
+    /// if the queue already holds `max_queue_depth` requests.
+    pub async fn acquire(&self, model: &str, sequences: usize) -> Result<QueuePermit, QueueFull> {
+        let queue = self.queue(model);
+        // A request larger than the cap would never be admitted; it runs alone instead
+        let sequences = sequences.clamp(1, queue.max_in_flight) as u32;
+
+        let ahead = queue.waiting.fetch_add(1, Ordering::SeqCst);
+        let waiting = Waiting(&queue.waiting);
+        if ahead >= self.settings.max_queue_depth {
+            drop(waiting);
+            queue.rejected.fetch_add(1, Ordering::Relaxed);
+            return Err(QueueFull {
+                model: model.to_string(),
+                queued: ahead,
+                retry_after_secs: queue.retry_after_secs(ahead),
+            });
+        }
+
+        let started = Instant::now();
+        let permit = Arc::clone(&queue.slots)
+            .acquire_many_owned(sequences)
+            .await
+            .expect("queue semaphores are never closed");
+        drop(waiting);
+        queue.admitted.fetch_add(1, Ordering::Relaxed);
+
+        Ok(QueuePermit {
+            _permit: permit,
+            queue: Arc::clone(&queue),
+            queue_time: started.elapsed(),
+            admitted_at: Instant::now(),
+        })
+    }
+
+    /// Queue state of every model that has received requests.
+    pub fn stats(&self) -> Vec<QueueStats> {
+        let queues = self.queues.lock().unwrap();
+        let mut stats: Vec<_> = queues.iter().map(|(model, queue)| QueueStats {
+            model: model.clone(),
+            in_flight: queue.max_in_flight - queue.slots.available_permits(),
+            waiting: queue.waiting.load(Ordering::SeqCst),
+            max_in_flight: queue.max_in_flight,
+            admitted: queue.admitted.load(Ordering::Relaxed),
+            rejected: queue.rejected.load(Ordering::Relaxed),
+            avg_service_ms: queue.avg_service_ms.load(Ordering::Relaxed),
+        }).collect();
+        stats.sort_by(|a, b| a.model.cmp(&b.model));
+        stats
+    }
+}
@@ -0,0 +1,296 @@
+use crate::api::chat::{EmbeddingCache, ModelCache};
+use crate::config::ResidencySettings;
+use crate::model_manager::GIB;
+use crate::{EmbeddingSession, InferenceSession};
+use serde::Serialize;
+use std::collections::{HashMap, VecDeque};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+use tokio::sync::RwLock;
+
+type Sessions = HashMap<String, Arc<RwLock<InferenceSession>>>;
+type EmbeddingSessions = HashMap<String, Arc<EmbeddingSession>>;
+
+/// Recent evictions kept for /v1/stats
+const EVICTION_LOG_LEN: usize = 32;
+
+#[derive(Debug, Clone, Copy, Serialize)]
+#[serde(rename_all = "snake_case")]
+pub enum EvictionReason {
+    /// Unloaded to make room for another model under the memory budget
+    Budget,
+    /// Idle for longer than its keep-alive
+    Idle,
+}
+
+#[derive(Debug, Clone, Serialize)]
+pub struct Eviction {
+    pub model: String,
+    pub reason: EvictionReason,
+    pub freed_bytes: u64,
+    /// Unix time of the eviction, in seconds
+    pub at: u64,
+}
+
+/// A model counted against the budget.
+#[derive(Debug, Clone, Serialize)]
+pub struct ResidentModel {
+    pub model: String,
+    pub estimated_bytes: u64,
+    pub idle_secs: u64,
+    pub pinned: bool,
+    /// None when the model is never unloaded for being idle
+    pub keep_alive_secs: Option<u64>,
+}
+
+#[derive(Debug, Clone, Serialize)]
+pub struct ResidencyStats {
+    pub budget_bytes: Option<u64>,
+    pub used_bytes: u64,
+    pub models: Vec<ResidentModel>,
+    pub evictions_total: u64,
+    pub recent_evictions: Vec<Eviction>,
+}
+
+struct Resident {
+    bytes: u64,
+    last_used: Instant,
+}
+
+/// Sessions taken out of their maps. Dropping the last reference frees the
+/// compiled model, which takes a while, so it happens after the map locks
+/// are released and off the async runtime.
+struct Unloaded {
+    _model: Option<Arc<RwLock<InferenceSession>>>,
+    _embedding: Option<Arc<EmbeddingSession>>,
+}
+
+/// Keeps the server's loaded models within a memory budget.
+///
+/// Each model is charged its estimated memory when its load starts. Models
+/// are only unloaded while idle, i.e. when the session map holds the last
+/// reference to them; pinned models are never unloaded.
+pub struct ResidencyManager {
+    settings: ResidencySettings,
+    models: ModelCache,
+    embeddings: EmbeddingCache,
+    residents: Mutex<HashMap<String, Resident>>,
+    evictions: Mutex<VecDeque<Eviction>>,
+    evictions_total: AtomicU64,
+}
+
+impl ResidencyManager {
+    pub fn new(settings: ResidencySettings, models: ModelCache, embeddings: EmbeddingCache) -> Self {
+        Self {
+            settings,
+            models,
+            embeddings,
+            residents: Mutex::new(HashMap::new()),
+            evictions: Mutex::new(VecDeque::new()),
+            evictions_total: AtomicU64::new(0),
+        }
+    }
+
+    fn budget_bytes(&self) -> Option<u64> {
+        self.settings.memory_budget_gb.map(|gb| gb as u64 * GIB)
+    }
+
+    fn is_pinned(&self, model: &str) -> bool {
+        self.settings.pinned.iter().any(|id| id == model)
+    }
+
+    fn keep_alive(&self, model: &str) -> Option<Duration> {
+        let secs = self.settings.model_keep_alive_secs.get(model).copied()
+            .unwrap_or(self.settings.keep_alive_secs);
+        (secs > 0 && !self.is_pinned(model)).then(|| Duration::from_secs(secs))
+    }
+
+    /// Mark a model as just used, pushing it to the back of the eviction order.
+    pub fn touch(&self, model: &str) {
+        if let Some(resident) = self.residents.lock().unwrap().get_mut(model) {
+            resident.last_used = Instant::now();
+        }
+    }
+
+    /// Charge `bytes` for a model about to load, unloading least recently used
+    /// idle models until it fits. Fails if busy and pinned models leave too
+    /// little room. Must be called off the async runtime, as loads are.
+    pub fn reserve(&self, model: &str, bytes: u64) -> anyhow::Result<()> {
+        let mut unloaded = Vec::new();
+        let reserved = self.reserve_locked(model, bytes, &mut unloaded);
+        drop(unloaded);
+        reserved
+    }
+
+    fn reserve_locked(&self, model: &str, bytes: u64, unloaded: &mut Vec<Unloaded>) -> anyhow::Result<()> {
+        let mut models = self.models.blocking_write();
+        let mut embeddings = self.embeddings.blocking_write();
+        let mut residents = self.residents.lock().unwrap();
+
+        if let Some(budget) = self.budget_bytes() {
+            let mut used: u64 = residents.values().map(|r| r.bytes).sum();
+            let mut candidates: Vec<_> = residents.iter()
+                .filter(|(id, _)| !self.is_pinned(id) && is_idle(id, &models, &embeddings))
+                .map(|(id, r)| (id.clone(), r.last_used))
+                .collect();
+            candidates.sort_by_key(|(_, last_used)| *last_used);
+
+            for (id, _) in candidates {
+                if used + bytes <= budget {
+                    break;
+                }
+                used -= self.evict(&id, EvictionReason::Budget, &mut models, &mut embeddings, &mut residents, unloaded);
+            }
+
+            if used + bytes > budget {
+                return Err(anyhow::anyhow!(
+                    "Loading {} needs {:.1} GiB but only {:.1} GiB of the {:.1} GiB model memory budget is free; the rest is held by busy or pinned models",
+                    model, gb(bytes), gb(budget.saturating_sub(used)), gb(budget)
+                ));
+            }
+        }
+
+        residents.insert(model.to_string(), Resident { bytes, last_used: Instant::now() });
+        Ok(())
+    }
+
+    /// Drop the charge for a model whose load failed.
+    pub fn release(&self, model: &str) {
+        self.residents.lock().unwrap().remove(model);
+    }
+
+    /// Charge the pipeline of a live conversation, unloading idle models if
+    /// needed. Conversations are never unloaded from here; their store
+    /// releases the charge when it drops the pipeline. Must be called off the
+    /// async runtime, like `reserve`.
+    pub fn reserve_conversation(&self, id: &str, bytes: u64) -> anyhow::Result<()> {
+        self.reserve(&conversation_key(id), bytes)
+    }
+
+    pub fn release_conversation(&self, id: &str) {
+        self.release(&conversation_key(id));
+    }
+
+    /// Unload idle models that have outlived their keep-alive.
+    pub async fn sweep(&self) {
+        let mut unloaded = Vec::new();
+        {
+            let mut models = self.models.write().await;
+            let mut embeddings = self.embeddings.write().await;
+            self.sweep_locked(&mut models, &mut embeddings, &mut unloaded);
+        }
+        if !unloaded.is_empty() {
+            tokio::task::spawn_blocking(move || drop(unloaded));
+        }
+    }
+
+    fn sweep_locked(&self, models: &mut Sessions, embeddings: &mut EmbeddingSessions, unloaded: &mut Vec<Unloaded>) {
+        let mut residents = self.residents.lock().unwrap();
+
+        // A model serving a long request was in use until now, not since it started
+        let now = Instant::now();
+        for (id, resident) in residents.iter_mut() {
+            if models.contains_key(id) || embeddings.contains_key(id) {
+                if !is_idle(id, models, embeddings) {
+                    resident.last_used = now;
+                }
+            }
+        }
+
+        let expired: Vec<String> = residents.iter()
+            .filter(|(id, r)| self.keep_alive(id).is_some_and(|keep_alive| r.last_used.elapsed() >= keep_alive))
+            .filter(|(id, _)| is_idle(id, models, embeddings))
+            .map(|(id, _)| id.clone())
+            .collect();
+
+        for id in expired {
+            self.evict(&id, EvictionReason::Idle, models, embeddings, &mut residents, unloaded);
+        }
+    }
+
+    /// Run `sweep` in the background for the life of the process.
+    pub fn spawn_sweeper(self: &Arc<Self>) {
+        let manager = Arc::clone(self);
+        tokio::spawn(async move {
+            let mut interval = tokio::time::interval(Duration::from_secs(15));
+            loop {
+                interval.tick().await;
+                manager.sweep().await;
+            }
+        });
+    }
+
+    fn evict(
+        &self,
+        model: &str,
+        reason: EvictionReason,
+        models: &mut Sessions,
+        embeddings: &mut EmbeddingSessions,
+        residents: &mut HashMap<String, Resident>,
+        unloaded: &mut Vec<Unloaded>,
+    ) -> u64 {
+        unloaded.push(Unloaded {
+            _model: models.remove(model),
+            _embedding: embeddings.remove(model),
+        });
+        let freed_bytes = residents.remove(model).map(|r| r.bytes).unwrap_or(0);
+
+        eprintln!("Unloaded model {} ({:?}, {:.1} GiB)", model, reason, gb(freed_bytes));
+        self.evictions_total.fetch_add(1, Ordering::Relaxed);
+
+        let mut evictions = self.evictions.lock().unwrap();
+        if evictions.len() == EVICTION_LOG_LEN {
+            evictions.pop_front();
+        }
+        evictions.push_back(Eviction {
+            model: model.to_string(),
+            reason,
+            freed_bytes,
+            at: SystemTime::now().duration_since(UNIX_EPOCH).unwrap_or_default().as_secs(),
+        });
+        freed_bytes
+    }
+
+    pub fn stats(&self) -> ResidencyStats {
+        let residents = self.residents.lock().unwrap();
+        let mut models: Vec<_> = residents.iter().map(|(id, r)| ResidentModel {
+            model: id.clone(),
+            estimated_bytes: r.bytes,
+            idle_secs: r.last_used.elapsed().as_secs(),
+            pinned: self.is_pinned(id),
+            keep_alive_secs: self.keep_alive(id).map(|d| d.as_secs()),
+        }).collect();
+        models.sort_by(|a, b| a.model.cmp(&b.model));
+
+        ResidencyStats {
+            budget_bytes: self.budget_bytes(),
+            used_bytes: residents.values().map(|r| r.bytes).sum(),
+            models,
+            evictions_total: self.evictions_total.load(Ordering::Relaxed),
+            recent_evictions: self.evictions.lock().unwrap().iter().cloned().collect(),
+        }
+    }
+}
+
+/// Residents are keyed by model id; conversations get their own namespace.
+fn conversation_key(id: &str) -> String {
+    format!("conversation:{}", id)
+}
+
+/// Loaded and referenced only by its session map. Models still loading are
+/// not in either map yet and so are never idle.
+fn is_idle(
+    model: &str,
+    models: &Sessions,
+    embeddings: &EmbeddingSessions,
+) -> bool {
+    if let Some(session) = models.get(model) {
+        return Arc::strong_count(session) == 1;
+    }
+    embeddings.get(model).is_some_and(|session| Arc::strong_count(session) == 1)
+}
+
+fn gb(bytes: u64) -> f64 {
+    bytes as f64 / GIB as f64
+}
@@ -13,10 +13,25 @@ async fn main() -> Result<()> {
 
     let registry = Arc::new(capi_core::Registry::new(db.clone()));
     let model_cache = Arc::new(RwLock::new(HashMap::new()));
+    let embedding_cache = Arc::new(RwLock::new(HashMap::new()));
+    let scheduler = capi_core::RequestScheduler::new(config.queue.clone());
+    let residency = Arc::new(capi_core::ResidencyManager::new(
+        config.residency.clone(),
+        model_cache.clone(),
+        embedding_cache.clone(),
+    ));
+    residency.spawn_sweeper();
+    let conversations = capi_core::ConversationStore::new(db.clone(), config.clone(), residency.clone());
 
     let state = capi_core::AppState {
         registry,
         model_cache,
+        embedding_cache,
+        conversations,
+        scheduler,
+        model_loader: capi_core::ModelLoader::new(),
+        embedding_loader: capi_core::ModelLoader::new(),
+        residency,
     };
 
     let app = capi_core::create_router(state);
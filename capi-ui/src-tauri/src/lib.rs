@@ -5,13 +5,15 @@ use tauri_plugin_shell::process::CommandChild;
 use std::sync::{Arc, Mutex};
 use tauri::{Emitter, Manager, State};
 use serde::Serialize;
+use futures::StreamExt;
 
 struct AppData {
     #[allow(dead_code)]
     db: Arc<capi_core::Database>,
     registry: Arc<capi_core::Registry>,
     downloader: capi_core::Downloader,
-    sessions: Arc<Mutex<std::collections::HashMap<String, capi_core::InferenceSession>>>,
+    // Per-session async lock so a generation can be awaited without holding the map lock
+    sessions: Arc<Mutex<std::collections::HashMap<String, Arc<tokio::sync::Mutex<capi_core::InferenceSession>>>>>,
 }
 
 struct ServerState {
@@ -125,6 +127,16 @@ async fn list_models(
         .map_err(|e| e.to_string())
 }
 
+#[tauri::command]
+async fn list_adapters(
+    model_id: String,
+    state: State<'_, AppData>,
+) -> Result<Vec<capi_core::db::AdapterRecord>, String> {
+    state.registry
+        .list_adapters(&model_id)
+        .map_err(|e| e.to_string())
+}
+
 #[tauri::command]
 async fn download_model(
     model_id: String,
@@ -239,6 +251,9 @@ async fn download_specific_file(
         last_used: None,
         estimated_memory_bytes: estimated_memory,
         context_override: None,
+        prompt_lookup: false,
+        model_type: capi_core::db::models::MODEL_TYPE_LLM.to_string(),
+        kv_cache_precision: None,
     };
 
     state.registry.add_model(model_record).map_err(|e| e.to_string())?;
@@ -298,7 +313,9 @@ async fn load_model_direct(
 
     let model_path = std::path::Path::new(&model.path);
 
-    let mut session = capi_core::InferenceSession::load_with_lock(model_path, &device, &model_id)
+    let kv_cache = state.registry.kv_cache_settings_for(&config, &model);
+    let adapters = state.registry.lora_adapters_for(&model).map_err(|e| e.to_string())?;
+    let mut session = capi_core::InferenceSession::load_with_lock(model_path, &device, &model_id, &kv_cache, &adapters)
         .map_err(|e| {
             e.to_string()
         })?;
@@ -310,14 +327,14 @@ async fn load_model_direct(
     let mut sessions = state.sessions.lock()
         .map_err(|_| "Failed to acquire sessions lock".to_string())?;
 
-    sessions.insert(model_id.clone(), session);
+    sessions.insert(model_id.clone(), Arc::new(tokio::sync::Mutex::new(session)));
 
     Ok(format!("Model {} loaded on {}", model_id, device))
 }
 
 #[derive(Serialize, Clone)]
-struct ChatToken {
-    token: String,
+struct ChatToken<'a> {
+    token: &'a str,
 }
 
 #[derive(Serialize, Clone)]
@@ -342,6 +359,25 @@ async fn get_chat_messages(state: State<'_, AppData>, session_id: String) -> Res
     }).map_err(|e| e.to_string())
 }
 
+/// Make a stored chat the one the model answers.
+fn resume_chat(state: &AppData, session: &mut capi_core::InferenceSession, session_id: &str) -> Result<(), String> {
+    if session.active_chat() == Some(session_id) {
+        return Ok(());
+    }
+
+    let history = state.db.with_connection(|conn| {
+        capi_core::db::chats::get_messages(conn, session_id)
+    }).map_err(|e| e.to_string())?;
+
+    session.resume_chat(session_id, history.into_iter()
+        .map(|m| capi_core::inference::genai::ChatMessage {
+            role: m.role,
+            content: m.content,
+        })
+        .collect())
+        .map_err(|e| e.to_string())
+}
+
 #[tauri::command]
 async fn delete_chat_session(state: State<'_, AppData>, session_id: String) -> Result<(), String> {
     state.db.with_connection(|conn| {
@@ -378,13 +414,32 @@ async fn chat_direct(
     model_id: String,
     prompt: String,
     session_id: Option<String>,
+    adapter: Option<String>,
+    adapter_alpha: Option<f32>,
     state: State<'_, AppData>,
 ) -> Result<ChatMetrics, String> {
-    let mut sessions = state.sessions.lock()
-        .map_err(|_| "Failed to acquire sessions lock".to_string())?;
+    let adapter = match adapter {
+        Some(id) => {
+            let record = state.registry.get_adapter(&id)
+                .map_err(|e| e.to_string())?
+                .ok_or_else(|| format!("Adapter not found: {}", id))?;
+            Some((record.id, adapter_alpha.unwrap_or(record.alpha as f32)))
+        }
+        None => None,
+    };
+
+    let session = {
+        let sessions = state.sessions.lock()
+            .map_err(|_| "Failed to acquire sessions lock".to_string())?;
+        sessions.get(&model_id)
+            .cloned()
+            .ok_or_else(|| format!("Model {} not loaded. Load it first.", model_id))?
+    };
+    let mut session = session.lock().await;
 
-    let session = sessions.get_mut(&model_id)
-        .ok_or_else(|| format!("Model {} not loaded. Load it first.", model_id))?;
+    // Adapters share the loaded base weights, so switching is immediate
+    session.set_adapter(adapter.as_ref().map(|(name, alpha)| (name.as_str(), *alpha)))
+        .map_err(|e| e.to_string())?;
 
     let start_time = std::time::Instant::now();
     let mut first_token_time = None;
@@ -393,7 +448,22 @@ async fn chat_direct(
     // Initial context estimate
     let prompt_tokens = session.get_context_tokens(); // last session context or initial
 
-    let (response, metrics) = session.generate_stream(&prompt, 4096, |token| {
+    // Generation runs on the bridge's worker thread; this command only awaits tokens
+    let mut task = match &session_id {
+        Some(sid) => {
+            resume_chat(&state, &mut session, sid)?;
+            session.start_chat_turn(&prompt, 4096)
+        }
+        None => {
+            // Messages without a stored chat continue one anonymous conversation
+            if !session.in_anonymous_chat() {
+                session.start_chat().map_err(|e| e.to_string())?;
+            }
+            session.start_generation(&prompt, 4096)
+        }
+    }.map_err(|e| e.to_string())?;
+
+    while let Some(token) = task.next().await {
         tokens_count += 1;
         let now = std::time::Instant::now();
         
@@ -401,7 +471,7 @@ async fn chat_direct(
             first_token_time = Some(now);
         }
 
-        app.emit("chat-token", ChatToken { token: token.to_string() }).ok();
+        app.emit("chat-token", ChatToken { token: &token }).ok();
         
         // Rolling metrics update
         if tokens_count % 2 == 0 {
@@ -415,9 +485,12 @@ async fn chat_direct(
                 total_context_tokens: prompt_tokens + tokens_count,
             }).ok();
         }
-        
-        true
-    }).map_err(|e| e.to_string())?;
+    }
+
+    let (response, metrics) = match session_id {
+        Some(_) => session.finish_chat_turn(task),
+        None => session.finish_generation(task),
+    }.map_err(|e| e.to_string())?;
 
     // Persist messages if session_id is provided
     if let Some(sid) = session_id {
@@ -588,6 +661,7 @@ pub fn run() {
             get_hardware_status,
             search_models,
             list_models,
+            list_adapters,
             download_model,
             remove_model,
             find_quantized_versions,